@@ -0,0 +1,113 @@
+#include "buffered_writer.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+#define BUFFERED_WRITER_LINE_CAPACITY 1024
+
+bool buffered_writer_open(BufferedWriter *writer, const char *filepath) {
+	writer->file = fopen(filepath, "wb");
+	writer->size = 0;
+	writer->offset = 0;
+	writer->failed = writer->file == NULL;
+
+	if (writer->failed)
+		fprintf(stderr, "ERROR: Couldn't open `%s` for writing.\n", filepath);
+
+	return !writer->failed;
+}
+
+bool buffered_writer_close(BufferedWriter *writer) {
+	if (writer->file == NULL)
+		return false;
+
+	buffered_writer_flush(writer);
+	if (fclose(writer->file) != 0)
+		writer->failed = true;
+	writer->file = NULL;
+
+	return !writer->failed;
+}
+
+void buffered_writer_flush(BufferedWriter *writer) {
+	if (!writer->failed && writer->size > 0) {
+		if (fwrite(writer->buffer, 1, writer->size, writer->file) != writer->size) {
+			fprintf(stderr, "ERROR: Couldn't write into the file, the rest of the output is dropped.\n");
+			writer->failed = true;
+		}
+	}
+
+	writer->size = 0;
+}
+
+void buffered_writer_write(BufferedWriter *writer, const void *data, size_t size) {
+	const uint8_t *bytes = data;
+	writer->offset += size;
+
+	while (size > 0) {
+		if (writer->size == BUFFERED_WRITER_CAPACITY)
+			buffered_writer_flush(writer);
+
+		size_t chunk = BUFFERED_WRITER_CAPACITY - writer->size;
+		if (chunk > size)
+			chunk = size;
+
+		memcpy(writer->buffer + writer->size, bytes, chunk);
+		writer->size += chunk;
+		bytes += chunk;
+		size -= chunk;
+	}
+}
+
+// Multi-byte values are written in the host byte order, readers map the files on the same kind of machine.
+void buffered_writer_write_u8(BufferedWriter *writer, uint8_t value) {
+	buffered_writer_write(writer, &value, sizeof(value));
+}
+
+void buffered_writer_write_u16(BufferedWriter *writer, uint16_t value) {
+	buffered_writer_write(writer, &value, sizeof(value));
+}
+
+void buffered_writer_write_u32(BufferedWriter *writer, uint32_t value) {
+	buffered_writer_write(writer, &value, sizeof(value));
+}
+
+void buffered_writer_write_u64(BufferedWriter *writer, uint64_t value) {
+	buffered_writer_write(writer, &value, sizeof(value));
+}
+
+// LEB128: 7 bits per byte, the high bit says that more bytes follow.
+void buffered_writer_write_varint(BufferedWriter *writer, uint64_t value) {
+	uint8_t bytes[10];
+	size_t count = 0;
+
+	do {
+		uint8_t byte = value & 0x7F;
+		value >>= 7;
+		bytes[count++] = (uint8_t)(value != 0 ? byte | 0x80 : byte);
+	} while (value != 0);
+
+	buffered_writer_write(writer, bytes, count);
+}
+
+// Small negative numbers stay small: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+void buffered_writer_write_zigzag(BufferedWriter *writer, int64_t value) {
+	buffered_writer_write_varint(writer, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+// Meant for short pieces of text like a CSV field, longer output is cut.
+void buffered_writer_printf(BufferedWriter *writer, const char *format, ...) {
+	char line[BUFFERED_WRITER_LINE_CAPACITY];
+	va_list args;
+
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+
+	if (length < 0)
+		return;
+	if ((size_t)length >= sizeof(line))
+		length = (int)sizeof(line) - 1;
+
+	buffered_writer_write(writer, line, (size_t)length);
+}
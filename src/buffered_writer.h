@@ -0,0 +1,35 @@
+#ifndef BUFFERED_WRITER_H
+#define BUFFERED_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BUFFERED_WRITER_CAPACITY (64 * 1024)
+
+// Collects small writes and hands them to the file in big chunks.
+// Errors are sticky: after the first failure everything is dropped and
+// buffered_writer_close reports it, so callers don't check every single write.
+typedef struct {
+	FILE *file;
+	size_t size;
+	uint64_t offset; // bytes written so far, including the buffered ones
+	bool failed;
+	uint8_t buffer[BUFFERED_WRITER_CAPACITY];
+} BufferedWriter;
+
+bool buffered_writer_open(BufferedWriter *writer, const char *filepath);
+bool buffered_writer_close(BufferedWriter *writer);
+void buffered_writer_flush(BufferedWriter *writer);
+
+void buffered_writer_write(BufferedWriter *writer, const void *data, size_t size);
+void buffered_writer_write_u8(BufferedWriter *writer, uint8_t value);
+void buffered_writer_write_u16(BufferedWriter *writer, uint16_t value);
+void buffered_writer_write_u32(BufferedWriter *writer, uint32_t value);
+void buffered_writer_write_u64(BufferedWriter *writer, uint64_t value);
+void buffered_writer_write_varint(BufferedWriter *writer, uint64_t value);
+void buffered_writer_write_zigzag(BufferedWriter *writer, int64_t value);
+void buffered_writer_printf(BufferedWriter *writer, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+#endif // !BUFFERED_WRITER_H
@@ -0,0 +1,674 @@
+#include "event_log.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define EVENT_LOG_MAGIC "GPEL"
+#define EVENT_LOG_TRAILER_MAGIC "GPEF"
+#define EVENT_LOG_TRAILER_SIZE (sizeof(uint64_t) + 4)
+
+#define CHUNK_KEYFRAME 'K'
+#define CHUNK_TICK 'T'
+#define CHUNK_FOOTER 'F'
+
+static_assert(STATES_COUNT <= 256, "Agent states are stored in a single byte.");
+static_assert(ENV_COUNT <= 256 && AA_COUNT <= 256 && DC_COUNT <= 256, "Enums are stored in a single byte.");
+static_assert(BOARD_WIDTH <= UINT16_MAX && BOARD_HEIGHT <= UINT16_MAX, "Positions are stored in 16 bits.");
+static_assert(MAX_LIFETIME <= UINT16_MAX, "Lifetime is stored in 16 bits.");
+
+typedef struct {
+	const uint8_t *at;
+	const uint8_t *end;
+	bool failed;
+} EventLogCursor;
+
+void event_log_write_keyframe(EventLog *log, const Game *game);
+
+uint8_t cursor_read_u8(EventLogCursor *cursor);
+uint16_t cursor_read_u16(EventLogCursor *cursor);
+uint32_t cursor_read_u32(EventLogCursor *cursor);
+uint64_t cursor_read_u64(EventLogCursor *cursor);
+uint64_t cursor_read_varint(EventLogCursor *cursor);
+int64_t cursor_read_zigzag(EventLogCursor *cursor);
+
+bool event_replay_read_header(EventReplay *replay, EventLogCursor *cursor);
+bool event_replay_read_footer(EventReplay *replay);
+bool event_replay_scan(EventReplay *replay, EventLogCursor *cursor);
+void event_replay_add_keyframe(EventReplay *replay, uint32_t tick, uint64_t offset);
+bool event_replay_decode(const EventReplay *replay, size_t keyframe_index, uint32_t tick, Game *out);
+void event_replay_read_world(const EventReplay *replay, Game *game);
+bool event_replay_read_keyframe(EventLogCursor *cursor, Game *game);
+bool event_replay_apply_tick(EventLogCursor *cursor, Game *game);
+bool event_replay_skip_tick(EventLogCursor *cursor);
+void event_replay_age_agent(Agent *agent);
+
+bool event_log_open(EventLog *log, const char *filepath, const Game *game, uint32_t keyframe_interval) {
+	memset(log, 0, sizeof(*log));
+
+	if (!buffered_writer_open(&log->writer, filepath))
+		return false;
+
+	log->keyframe_interval = keyframe_interval > 0 ? keyframe_interval : EVENT_LOG_DEFAULT_KEYFRAME_INTERVAL;
+
+	BufferedWriter *w = &log->writer;
+	buffered_writer_write(w, EVENT_LOG_MAGIC, 4);
+	buffered_writer_write_u32(w, EVENT_LOG_VERSION);
+	buffered_writer_write_u32(w, BOARD_WIDTH);
+	buffered_writer_write_u32(w, BOARD_HEIGHT);
+	buffered_writer_write_u32(w, AGENTS_COUNT);
+	buffered_writer_write_u32(w, FOOD_COUNT);
+	buffered_writer_write_u32(w, WALLS_COUNT);
+	buffered_writer_write_u32(w, GENES_COUNT);
+	buffered_writer_write_u32(w, log->keyframe_interval);
+
+	// Walls and food never move and chromosomes never change during a game, they are stored once.
+	for (size_t i = 0; i < WALLS_COUNT; ++i) {
+		buffered_writer_write_u16(w, (uint16_t)game->walls[i].pos.x);
+		buffered_writer_write_u16(w, (uint16_t)game->walls[i].pos.y);
+	}
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		buffered_writer_write_u16(w, (uint16_t)game->food[i].pos.x);
+		buffered_writer_write_u16(w, (uint16_t)game->food[i].pos.y);
+	}
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		for (size_t j = 0; j < GENES_COUNT; ++j) {
+			const Gene *gene = &game->genomes[i].genes[j];
+			buffered_writer_write_u8(w, (uint8_t)gene->current_state);
+			buffered_writer_write_u8(w, (uint8_t)gene->environment);
+			buffered_writer_write_u8(w, (uint8_t)gene->action);
+			buffered_writer_write_u8(w, (uint8_t)gene->next_state);
+		}
+	}
+
+	event_log_write_keyframe(log, game);
+
+	if (w->failed) {
+		buffered_writer_close(w);
+		free(log->keyframes);
+		log->keyframes = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+bool event_log_close(EventLog *log) {
+	BufferedWriter *w = &log->writer;
+	uint64_t footer_offset = w->offset;
+
+	buffered_writer_write_u8(w, CHUNK_FOOTER);
+	buffered_writer_write_u32(w, log->tick);
+	buffered_writer_write_u32(w, (uint32_t)log->keyframes_count);
+	for (size_t i = 0; i < log->keyframes_count; ++i) {
+		buffered_writer_write_u32(w, log->keyframes[i].tick);
+		buffered_writer_write_u64(w, log->keyframes[i].offset);
+	}
+	buffered_writer_write_u64(w, footer_offset);
+	buffered_writer_write(w, EVENT_LOG_TRAILER_MAGIC, 4);
+
+	free(log->keyframes);
+	log->keyframes = NULL;
+	log->keyframes_count = 0;
+	log->keyframes_capacity = 0;
+
+	bool result = buffered_writer_close(w);
+	if (result)
+		fprintf(stdout, "INFO: Event log with %u ticks was successfully written.\n", log->tick);
+
+	return result;
+}
+
+void event_log_begin_tick(EventLog *log) {
+	buffered_writer_write_u8(&log->writer, CHUNK_TICK);
+	log->previous_agent = 0;
+}
+
+void event_log_action(EventLog *log,
+		      size_t agent_index,
+		      size_t gene_index,
+		      VerboseAction outcome,
+		      bool moved,
+		      size_t target_index) {
+	EventType type = EV_IDLE;
+
+	switch (outcome) {
+	case VA_NOTHING: type = EV_IDLE; break;
+	case VA_STEP: type = moved ? EV_MOVE : EV_IDLE; break;
+	case VA_FOOD: type = EV_EAT; break;
+	case VA_ATTACK: type = EV_ATTACK; break;
+	case VA_TURN_LEFT: type = EV_TURN_LEFT; break;
+	case VA_TURN_RIGHT: type = EV_TURN_RIGHT; break;
+	case VA_COUNT:
+	default: assert(0 && "That's not supposed to happen."); break;
+	}
+
+	BufferedWriter *w = &log->writer;
+	buffered_writer_write_u8(w, (uint8_t)type);
+	buffered_writer_write_zigzag(w, (int64_t)agent_index - (int64_t)log->previous_agent);
+	buffered_writer_write_varint(w, gene_index);
+	if (type == EV_EAT || type == EV_ATTACK)
+		buffered_writer_write_varint(w, target_index);
+
+	log->previous_agent = agent_index;
+}
+
+// Deaths don't move `previous_agent`, victims don't die in the order agents act.
+void event_log_death(EventLog *log, size_t agent_index, DeathCause cause) {
+	BufferedWriter *w = &log->writer;
+	buffered_writer_write_u8(w, EV_DEATH);
+	buffered_writer_write_zigzag(w, (int64_t)agent_index - (int64_t)log->previous_agent);
+	buffered_writer_write_u8(w, (uint8_t)cause);
+}
+
+void event_log_end_tick(EventLog *log, const Game *game) {
+	buffered_writer_write_u8(&log->writer, EV_END);
+	log->tick += 1;
+
+	if (log->tick % log->keyframe_interval == 0)
+		event_log_write_keyframe(log, game);
+}
+
+void event_log_write_keyframe(EventLog *log, const Game *game) {
+	BufferedWriter *w = &log->writer;
+
+	if (log->keyframes_count == log->keyframes_capacity) {
+		size_t capacity = log->keyframes_capacity == 0 ? 64 : log->keyframes_capacity * 2;
+		EventLogKeyframe *keyframes = realloc(log->keyframes, capacity * sizeof(*keyframes));
+
+		if (keyframes == NULL) {
+			// Still a valid log, the reader rebuilds the index by scanning it.
+			fprintf(stderr, "ERROR: Couldn't grow the keyframe index of the event log.\n");
+		} else {
+			log->keyframes = keyframes;
+			log->keyframes_capacity = capacity;
+		}
+	}
+
+	if (log->keyframes_count < log->keyframes_capacity) {
+		log->keyframes[log->keyframes_count].tick = log->tick;
+		log->keyframes[log->keyframes_count].offset = w->offset;
+		log->keyframes_count += 1;
+	}
+
+	buffered_writer_write_u8(w, CHUNK_KEYFRAME);
+	buffered_writer_write_u32(w, log->tick);
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		const Agent *a = &game->agents[i];
+		buffered_writer_write_u16(w, (uint16_t)a->pos.x);
+		buffered_writer_write_u16(w, (uint16_t)a->pos.y);
+		buffered_writer_write_u8(w, (uint8_t)a->direction);
+		buffered_writer_write_u8(w, (uint8_t)a->current_state);
+		buffered_writer_write_u8(w, (uint8_t)a->death_cause);
+		buffered_writer_write_zigzag(w, a->hunger);
+		buffered_writer_write_zigzag(w, a->health);
+		buffered_writer_write_u16(w, (uint16_t)a->lifetime);
+		buffered_writer_write_varint(w, a->food_eaten);
+		buffered_writer_write_varint(w, a->attacks_dealt);
+		buffered_writer_write_varint(w, a->attacks_received);
+	}
+	for (size_t i = 0; i < FOOD_COUNT; ++i)
+		buffered_writer_write_zigzag(w, game->food[i].quantity);
+}
+
+uint8_t cursor_read_u8(EventLogCursor *cursor) {
+	if (cursor->failed || cursor->at >= cursor->end) {
+		cursor->failed = true;
+		return 0;
+	}
+
+	return *cursor->at++;
+}
+
+uint16_t cursor_read_u16(EventLogCursor *cursor) {
+	uint16_t value = 0;
+
+	if (cursor->failed || (size_t)(cursor->end - cursor->at) < sizeof(value)) {
+		cursor->failed = true;
+		return 0;
+	}
+
+	memcpy(&value, cursor->at, sizeof(value));
+	cursor->at += sizeof(value);
+	return value;
+}
+
+uint32_t cursor_read_u32(EventLogCursor *cursor) {
+	uint32_t value = 0;
+
+	if (cursor->failed || (size_t)(cursor->end - cursor->at) < sizeof(value)) {
+		cursor->failed = true;
+		return 0;
+	}
+
+	memcpy(&value, cursor->at, sizeof(value));
+	cursor->at += sizeof(value);
+	return value;
+}
+
+uint64_t cursor_read_u64(EventLogCursor *cursor) {
+	uint64_t value = 0;
+
+	if (cursor->failed || (size_t)(cursor->end - cursor->at) < sizeof(value)) {
+		cursor->failed = true;
+		return 0;
+	}
+
+	memcpy(&value, cursor->at, sizeof(value));
+	cursor->at += sizeof(value);
+	return value;
+}
+
+uint64_t cursor_read_varint(EventLogCursor *cursor) {
+	uint64_t value = 0;
+
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		uint8_t byte = cursor_read_u8(cursor);
+		value |= (uint64_t)(byte & 0x7F) << shift;
+
+		if ((byte & 0x80) == 0)
+			return value;
+	}
+
+	cursor->failed = true;
+	return 0;
+}
+
+int64_t cursor_read_zigzag(EventLogCursor *cursor) {
+	uint64_t value = cursor_read_varint(cursor);
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+bool event_replay_open(EventReplay *replay, const char *filepath) {
+	memset(replay, 0, sizeof(*replay));
+	replay->fd = open(filepath, O_RDONLY);
+
+	if (replay->fd < 0) {
+		fprintf(stderr, "ERROR: Couldn't open the event log `%s`.\n", filepath);
+		return false;
+	}
+
+	struct stat file_stat;
+	if (fstat(replay->fd, &file_stat) != 0 || file_stat.st_size == 0) {
+		fprintf(stderr, "ERROR: The event log `%s` is empty.\n", filepath);
+		close(replay->fd);
+		return false;
+	}
+
+	replay->size = (size_t)file_stat.st_size;
+	void *data = mmap(NULL, replay->size, PROT_READ, MAP_PRIVATE, replay->fd, 0);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "ERROR: Couldn't map the event log `%s`.\n", filepath);
+		close(replay->fd);
+		return false;
+	}
+	replay->data = data;
+
+	EventLogCursor cursor = { replay->data, replay->data + replay->size, false };
+	if (!event_replay_read_header(replay, &cursor)) {
+		event_replay_close(replay);
+		return false;
+	}
+
+	// A log that wasn't closed properly (crash, ^C) has no footer, but it's still readable up to the last full tick.
+	if (!event_replay_read_footer(replay) && !event_replay_scan(replay, &cursor)) {
+		fprintf(stderr, "ERROR: The event log `%s` doesn't have a single keyframe.\n", filepath);
+		event_replay_close(replay);
+		return false;
+	}
+
+	fprintf(stdout,
+		"INFO: Event log with %u ticks and %zu keyframes was successfully mapped.\n",
+		replay->ticks_count,
+		replay->keyframes_count);
+	return true;
+}
+
+void event_replay_close(EventReplay *replay) {
+	if (replay->data != NULL)
+		munmap((void *)replay->data, replay->size);
+	if (replay->fd >= 0)
+		close(replay->fd);
+
+	free(replay->keyframes);
+	memset(replay, 0, sizeof(*replay));
+	replay->fd = -1;
+}
+
+bool event_replay_read_header(EventReplay *replay, EventLogCursor *cursor) {
+	if ((size_t)(cursor->end - cursor->at) < 4 || memcmp(cursor->at, EVENT_LOG_MAGIC, 4) != 0) {
+		fprintf(stderr, "ERROR: That's not an event log.\n");
+		return false;
+	}
+	cursor->at += 4;
+
+	uint32_t version = cursor_read_u32(cursor);
+	uint32_t board_width = cursor_read_u32(cursor);
+	uint32_t board_height = cursor_read_u32(cursor);
+	uint32_t agents_count = cursor_read_u32(cursor);
+	uint32_t food_count = cursor_read_u32(cursor);
+	uint32_t walls_count = cursor_read_u32(cursor);
+	uint32_t genes_count = cursor_read_u32(cursor);
+	replay->keyframe_interval = cursor_read_u32(cursor);
+
+	if (cursor->failed || version != EVENT_LOG_VERSION) {
+		fprintf(stderr, "ERROR: Unsupported event log version.\n");
+		return false;
+	}
+
+	if (board_width != BOARD_WIDTH || board_height != BOARD_HEIGHT || agents_count != AGENTS_COUNT ||
+	    food_count != FOOD_COUNT || walls_count != WALLS_COUNT || genes_count != GENES_COUNT) {
+		fprintf(stderr, "ERROR: The event log was recorded with different world constants.\n");
+		return false;
+	}
+
+	replay->world_offset = (size_t)(cursor->at - replay->data);
+
+	const size_t WORLD_SIZE = (WALLS_COUNT + FOOD_COUNT) * 2 * sizeof(uint16_t) + AGENTS_COUNT * GENES_COUNT * 4;
+	if ((size_t)(cursor->end - cursor->at) < WORLD_SIZE) {
+		fprintf(stderr, "ERROR: The event log is truncated.\n");
+		return false;
+	}
+	cursor->at += WORLD_SIZE;
+
+	return true;
+}
+
+bool event_replay_read_footer(EventReplay *replay) {
+	if (replay->size < replay->world_offset + EVENT_LOG_TRAILER_SIZE)
+		return false;
+
+	const uint8_t *trailer = replay->data + replay->size - EVENT_LOG_TRAILER_SIZE;
+	if (memcmp(trailer + sizeof(uint64_t), EVENT_LOG_TRAILER_MAGIC, 4) != 0)
+		return false;
+
+	uint64_t footer_offset = 0;
+	memcpy(&footer_offset, trailer, sizeof(footer_offset));
+	if (footer_offset < replay->world_offset || footer_offset >= replay->size)
+		return false;
+
+	EventLogCursor cursor = { replay->data + footer_offset, trailer, false };
+	if (cursor_read_u8(&cursor) != CHUNK_FOOTER)
+		return false;
+
+	replay->ticks_count = cursor_read_u32(&cursor);
+	uint32_t keyframes_count = cursor_read_u32(&cursor);
+	for (uint32_t i = 0; i < keyframes_count && !cursor.failed; ++i) {
+		uint32_t tick = cursor_read_u32(&cursor);
+		uint64_t offset = cursor_read_u64(&cursor);
+		if (!cursor.failed && offset < footer_offset)
+			event_replay_add_keyframe(replay, tick, offset);
+	}
+
+	return !cursor.failed && replay->keyframes_count > 0;
+}
+
+bool event_replay_scan(EventReplay *replay, EventLogCursor *cursor) {
+	free(replay->keyframes);
+	replay->keyframes = NULL;
+	replay->keyframes_count = 0;
+	replay->ticks_count = 0;
+
+	Game *scratch = malloc(sizeof(*scratch));
+	if (scratch == NULL)
+		return false;
+
+	while (cursor->at < cursor->end) {
+		uint64_t offset = (uint64_t)(cursor->at - replay->data);
+		uint8_t chunk = cursor_read_u8(cursor);
+
+		if (chunk == CHUNK_KEYFRAME) {
+			uint32_t tick = cursor_read_u32(cursor);
+			if (!event_replay_read_keyframe(cursor, scratch))
+				break;
+			event_replay_add_keyframe(replay, tick, offset);
+		} else if (chunk == CHUNK_TICK) {
+			if (!event_replay_skip_tick(cursor))
+				break;
+			replay->ticks_count += 1;
+		} else {
+			break;
+		}
+	}
+
+	free(scratch);
+	return replay->keyframes_count > 0;
+}
+
+void event_replay_add_keyframe(EventReplay *replay, uint32_t tick, uint64_t offset) {
+	EventLogKeyframe *keyframes =
+		realloc(replay->keyframes, (replay->keyframes_count + 1) * sizeof(*replay->keyframes));
+
+	if (keyframes == NULL)
+		return;
+
+	replay->keyframes = keyframes;
+	replay->keyframes[replay->keyframes_count].tick = tick;
+	replay->keyframes[replay->keyframes_count].offset = offset;
+	replay->keyframes_count += 1;
+}
+
+bool event_replay_seek(const EventReplay *replay, uint32_t tick, Game *out) {
+	if (replay->keyframes_count == 0)
+		return false;
+
+	if (tick > replay->ticks_count)
+		tick = replay->ticks_count;
+
+	// The last keyframe at or before `tick`.
+	size_t low = 0;
+	size_t high = replay->keyframes_count;
+	while (high - low > 1) {
+		size_t middle = low + (high - low) / 2;
+		if (replay->keyframes[middle].tick <= tick)
+			low = middle;
+		else
+			high = middle;
+	}
+
+	return event_replay_decode(replay, low, tick, out);
+}
+
+// Keyframes don't carry the action/gene history, this one decodes the whole log up to `tick`
+// so that the history of every agent is complete. Costs O(tick) instead of O(keyframe interval).
+bool event_replay_seek_with_history(const EventReplay *replay, uint32_t tick, Game *out) {
+	if (replay->keyframes_count == 0)
+		return false;
+
+	if (tick > replay->ticks_count)
+		tick = replay->ticks_count;
+
+	return event_replay_decode(replay, 0, tick, out);
+}
+
+bool event_replay_decode(const EventReplay *replay, size_t keyframe_index, uint32_t tick, Game *out) {
+	const EventLogKeyframe *keyframe = &replay->keyframes[keyframe_index];
+	EventLogCursor cursor = { replay->data + keyframe->offset, replay->data + replay->size, false };
+
+	event_replay_read_world(replay, out);
+	if (cursor_read_u8(&cursor) != CHUNK_KEYFRAME || cursor_read_u32(&cursor) != keyframe->tick ||
+	    !event_replay_read_keyframe(&cursor, out))
+		return false;
+
+	for (uint32_t t = keyframe->tick; t < tick;) {
+		uint8_t chunk = cursor_read_u8(&cursor);
+
+		if (chunk == CHUNK_KEYFRAME) {
+			cursor_read_u32(&cursor);
+			if (!event_replay_read_keyframe(&cursor, out))
+				return false;
+		} else if (chunk == CHUNK_TICK) {
+			if (!event_replay_apply_tick(&cursor, out))
+				return false;
+			t += 1;
+		} else {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void event_replay_read_world(const EventReplay *replay, Game *game) {
+	EventLogCursor cursor = { replay->data + replay->world_offset, replay->data + replay->size, false };
+	memset(game, 0, sizeof(*game));
+
+	for (size_t i = 0; i < WALLS_COUNT; ++i) {
+		game->walls[i].pos.x = (int16_t)cursor_read_u16(&cursor);
+		game->walls[i].pos.y = (int16_t)cursor_read_u16(&cursor);
+	}
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		game->food[i].pos.x = (int16_t)cursor_read_u16(&cursor);
+		game->food[i].pos.y = (int16_t)cursor_read_u16(&cursor);
+	}
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		game->agents[i].index = i;
+
+		for (size_t j = 0; j < GENES_COUNT; ++j) {
+			Gene *gene = &game->genomes[i].genes[j];
+			gene->current_state = cursor_read_u8(&cursor);
+			gene->environment = (Environment)cursor_read_u8(&cursor);
+			gene->action = (AgentAction)cursor_read_u8(&cursor);
+			gene->next_state = cursor_read_u8(&cursor);
+		}
+	}
+}
+
+bool event_replay_read_keyframe(EventLogCursor *cursor, Game *game) {
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		Agent *a = &game->agents[i];
+		a->pos.x = (int16_t)cursor_read_u16(cursor);
+		a->pos.y = (int16_t)cursor_read_u16(cursor);
+		a->direction = (Direction)(cursor_read_u8(cursor) & 3);
+		a->current_state = cursor_read_u8(cursor);
+		a->death_cause = (DeathCause)cursor_read_u8(cursor);
+		a->hunger = (int16_t)cursor_read_zigzag(cursor);
+		a->health = (int16_t)cursor_read_zigzag(cursor);
+		a->lifetime = cursor_read_u16(cursor);
+		a->food_eaten = (size_t)cursor_read_varint(cursor);
+		a->attacks_dealt = (size_t)cursor_read_varint(cursor);
+		a->attacks_received = (size_t)cursor_read_varint(cursor);
+	}
+	for (size_t i = 0; i < FOOD_COUNT; ++i)
+		game->food[i].quantity = (int)cursor_read_zigzag(cursor);
+
+	return !cursor->failed;
+}
+
+// Mirrors game_step: agents take their turns in index order, the ones without an event
+// still get older, and everybody alive gets hungrier at the end of the tick.
+bool event_replay_apply_tick(EventLogCursor *cursor, Game *game) {
+	size_t turn = 0;
+	size_t previous_agent = 0;
+
+	for (;;) {
+		uint8_t type = cursor_read_u8(cursor);
+		if (cursor->failed || type >= EV_COUNT)
+			return false;
+		if (type == EV_END)
+			break;
+
+		int64_t agent_index = (int64_t)previous_agent + cursor_read_zigzag(cursor);
+		if (agent_index < 0 || agent_index >= AGENTS_COUNT)
+			return false;
+
+		if (type == EV_DEATH) {
+			// Deaths follow from the rules applied below, the event is only there for readers of the stream.
+			cursor_read_u8(cursor);
+			continue;
+		}
+
+		previous_agent = (size_t)agent_index;
+		for (; turn < previous_agent; ++turn)
+			event_replay_age_agent(&game->agents[turn]);
+		turn = previous_agent + 1;
+
+		Agent *agent = &game->agents[previous_agent];
+		uint64_t gene_index = cursor_read_varint(cursor);
+		if (agent->health <= 0 || gene_index >= GENES_COUNT || !age_agent(agent))
+			return false;
+
+		const Gene *gene = &game->genomes[previous_agent].genes[gene_index];
+		VerboseAction outcome = gene->action == AA_STEP ? VA_STEP : VA_NOTHING;
+
+		switch ((EventType)type) {
+		case EV_IDLE: break;
+		case EV_MOVE: move_agent(agent); break;
+		case EV_TURN_LEFT:
+			turn_agent(agent, AA_TURN_LEFT);
+			outcome = VA_TURN_LEFT;
+			break;
+		case EV_TURN_RIGHT:
+			turn_agent(agent, AA_TURN_RIGHT);
+			outcome = VA_TURN_RIGHT;
+			break;
+		case EV_EAT: {
+			uint64_t food_index = cursor_read_varint(cursor);
+			if (food_index >= FOOD_COUNT)
+				return false;
+			feed_agent(agent, &game->food[food_index]);
+			outcome = VA_FOOD;
+		} break;
+		case EV_ATTACK: {
+			uint64_t victim_index = cursor_read_varint(cursor);
+			if (victim_index >= AGENTS_COUNT)
+				return false;
+			attack_agent(agent, &game->agents[victim_index]);
+			outcome = VA_ATTACK;
+		} break;
+		case EV_END:
+		case EV_DEATH:
+		case EV_COUNT:
+		default: return false;
+		}
+
+#if GAME_RECORD_HISTORY
+		agent->action_history[agent->lifetime] = outcome;
+		agent->used_genes_history[agent->lifetime] = (int)gene_index;
+#else
+		(void)outcome;
+#endif
+		agent->gene_usage[gene_index] += 1;
+		agent->current_state = gene->next_state;
+	}
+
+	for (; turn < AGENTS_COUNT; ++turn)
+		event_replay_age_agent(&game->agents[turn]);
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		if (game->agents[i].health > 0)
+			starve_agent(&game->agents[i]);
+	}
+
+	return !cursor->failed;
+}
+
+void event_replay_age_agent(Agent *agent) {
+	if (agent->health > 0)
+		age_agent(agent);
+}
+
+bool event_replay_skip_tick(EventLogCursor *cursor) {
+	for (;;) {
+		uint8_t type = cursor_read_u8(cursor);
+		if (cursor->failed || type >= EV_COUNT)
+			return false;
+		if (type == EV_END)
+			return true;
+
+		cursor_read_zigzag(cursor);
+		if (type == EV_DEATH) {
+			cursor_read_u8(cursor);
+			continue;
+		}
+
+		cursor_read_varint(cursor);
+		if (type == EV_EAT || type == EV_ATTACK)
+			cursor_read_varint(cursor);
+	}
+}
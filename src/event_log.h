@@ -0,0 +1,95 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include "buffered_writer.h"
+#include "game.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define EVENT_LOG_FILEPATH "./output/replay.gplog"
+#define EVENT_LOG_DEFAULT_KEYFRAME_INTERVAL 64
+#define EVENT_LOG_VERSION 2
+
+/*
+ * Layout of the file (all multi-byte values in the host byte order):
+ *
+ *    header       "GPEL", version, board size, entity counts, keyframe interval
+ *    world        wall positions, food positions, chromosomes of all agents
+ *    'K' chunk    keyframe of tick 0: every agent (with its counters) and food quantity
+ *    'T' chunk    events of tick 1, terminated by EV_END
+ *    'T' chunk    events of tick 2
+ *    ...
+ *    'K' chunk    keyframe after every `keyframe_interval` ticks
+ *    ...
+ *    'F' chunk    ticks count and the table of keyframes (tick, file offset)
+ *    trailer      offset of the 'F' chunk and "GPEF"
+ *
+ * Every event is a type byte, the zigzag varint delta of the agent index against the previous
+ * acting agent of this tick, the varint gene index and, for eating and attacks, the varint index
+ * of the food/victim. Deaths carry the cause instead of a gene.
+ *
+ * Seeking decodes the closest keyframe before the tick and applies at most `keyframe_interval`
+ * ticks of events to it with the same rules game_step uses. Keyframes don't store the history
+ * and gene usage, only a replay decoded from the very first keyframe has them complete.
+ */
+
+typedef enum {
+	EV_END = 0,
+	EV_IDLE, // a gene fired, but nothing visible happened (AA_NOTHING, bumped into a wall)
+	EV_MOVE,
+	EV_TURN_LEFT,
+	EV_TURN_RIGHT,
+	EV_EAT,
+	EV_ATTACK,
+	EV_DEATH,
+	EV_COUNT,
+} EventType;
+
+typedef struct {
+	uint32_t tick;
+	uint64_t offset;
+} EventLogKeyframe;
+
+struct EventLog {
+	BufferedWriter writer;
+	uint32_t keyframe_interval;
+	uint32_t tick;
+	size_t previous_agent;
+	EventLogKeyframe *keyframes;
+	size_t keyframes_count;
+	size_t keyframes_capacity;
+};
+
+bool event_log_open(EventLog *log, const char *filepath, const Game *game, uint32_t keyframe_interval);
+bool event_log_close(EventLog *log);
+
+void event_log_begin_tick(EventLog *log);
+void event_log_action(EventLog *log,
+		      size_t agent_index,
+		      size_t gene_index,
+		      VerboseAction outcome,
+		      bool moved,
+		      size_t target_index);
+void event_log_death(EventLog *log, size_t agent_index, DeathCause cause);
+void event_log_end_tick(EventLog *log, const Game *game);
+
+// Read-only view of a recorded log, the file is mapped and never copied.
+typedef struct {
+	int fd;
+	const uint8_t *data;
+	size_t size;
+	uint32_t keyframe_interval;
+	uint32_t ticks_count;
+	size_t world_offset;
+	EventLogKeyframe *keyframes;
+	size_t keyframes_count;
+} EventReplay;
+
+bool event_replay_open(EventReplay *replay, const char *filepath);
+void event_replay_close(EventReplay *replay);
+bool event_replay_seek(const EventReplay *replay, uint32_t tick, Game *out);
+bool event_replay_seek_with_history(const EventReplay *replay, uint32_t tick, Game *out);
+
+#endif // !EVENT_LOG_H
@@ -0,0 +1,230 @@
+#include "evolution.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static_assert(EVOLUTION_HISTORY_CAPACITY % 2 == 0, "History is compacted by merging pairs of samples.");
+
+void *island_thread(void *arg);
+void island_run_generation(Island *island);
+void evolution_report(Evolution *evolution,
+		      const Island *island,
+		      size_t best_agent_index,
+		      size_t best_lifetime,
+		      float mean_lifetime);
+void evolution_record_history(Evolution *evolution, size_t generation, float best, float mean);
+
+Evolution *evolution_start(const Game *seed_game, size_t islands_count, unsigned int seed) {
+	Evolution *evolution = calloc(1, sizeof(*evolution));
+
+	if (evolution == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate the evolution islands.\n");
+		return NULL;
+	}
+
+	if (islands_count < 1)
+		islands_count = 1;
+	if (islands_count > EVOLUTION_MAX_ISLANDS)
+		islands_count = EVOLUTION_MAX_ISLANDS;
+
+	atomic_init(&evolution->stop, false);
+	atomic_init(&evolution->best_version, 0);
+	pthread_mutex_init(&evolution->mutex, NULL);
+	evolution->history_stride = 1;
+
+	// The first island continues from whatever was on the board, the rest start from scratch,
+	// so that they don't spend the first generations exploring exactly the same genomes.
+	seed_random(seed);
+	for (size_t i = 0; i < islands_count; ++i) {
+		Island *island = &evolution->islands[i];
+		island->evolution = evolution;
+		island->seed = seed + (unsigned int)i + 1;
+
+		if (i == 0 && seed_game != NULL) {
+			memcpy(&island->games[0], seed_game, sizeof(*seed_game));
+		} else {
+			initialize_game(&island->games[0]);
+		}
+	}
+
+	for (size_t i = 0; i < islands_count; ++i) {
+		if (pthread_create(&evolution->islands[i].thread, NULL, island_thread, &evolution->islands[i]) != 0) {
+			fprintf(stderr, "ERROR: Couldn't start the evolution thread for island %zu.\n", i);
+			break;
+		}
+		evolution->islands_count += 1;
+	}
+
+	if (evolution->islands_count == 0) {
+		pthread_mutex_destroy(&evolution->mutex);
+		free(evolution);
+		return NULL;
+	}
+
+	return evolution;
+}
+
+void evolution_stop(Evolution *evolution) {
+	if (evolution == NULL)
+		return;
+
+	atomic_store(&evolution->stop, true);
+	for (size_t i = 0; i < evolution->islands_count; ++i)
+		pthread_join(evolution->islands[i].thread, NULL);
+
+	pthread_mutex_destroy(&evolution->mutex);
+	free(evolution);
+}
+
+// Leave one core for the UI and the replay.
+size_t evolution_default_islands_count(void) {
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (cores <= 2)
+		return 1;
+	if (cores - 1 > EVOLUTION_MAX_ISLANDS)
+		return EVOLUTION_MAX_ISLANDS;
+	return (size_t)(cores - 1);
+}
+
+size_t evolution_best_version(Evolution *evolution) {
+	return atomic_load(&evolution->best_version);
+}
+
+size_t evolution_generations_done(Evolution *evolution) {
+	pthread_mutex_lock(&evolution->mutex);
+	size_t result = evolution->generations_done;
+	pthread_mutex_unlock(&evolution->mutex);
+
+	return result;
+}
+
+bool evolution_copy_best(Evolution *evolution, Game *out, size_t *generation, size_t *best_agent_index) {
+	bool result = false;
+
+	pthread_mutex_lock(&evolution->mutex);
+	if (atomic_load(&evolution->best_version) > 0) {
+		memcpy(out, &evolution->best_start, sizeof(*out));
+		*generation = evolution->best_generation;
+		*best_agent_index = evolution->best_agent_index;
+		result = true;
+	}
+	pthread_mutex_unlock(&evolution->mutex);
+
+	return result;
+}
+
+// Fills `best` and `mean` with one value per history bucket, returns the number of buckets.
+size_t evolution_copy_history(Evolution *evolution, float *best, float *mean, size_t capacity) {
+	pthread_mutex_lock(&evolution->mutex);
+
+	size_t count = evolution->history_count < capacity ? evolution->history_count : capacity;
+	for (size_t i = 0; i < count; ++i) {
+		const FitnessSample *sample = &evolution->history[i];
+		best[i] = sample->best;
+		mean[i] = sample->count > 0 ? sample->mean_sum / (float)sample->count : 0.f;
+	}
+
+	pthread_mutex_unlock(&evolution->mutex);
+	return count;
+}
+
+void *island_thread(void *arg) {
+	Island *island = arg;
+	seed_random(island->seed);
+
+	while (!atomic_load_explicit(&island->evolution->stop, memory_order_relaxed))
+		island_run_generation(island);
+
+	return NULL;
+}
+
+void island_run_generation(Island *island) {
+	Game *game = &island->games[island->current_game];
+	memcpy(&island->start, game, sizeof(island->start));
+
+	DecisionTable table;
+	const DecisionTable *decisions = decision_table_build(&table, game);
+	while (!is_everyone_dead(game)) {
+		if (atomic_load_explicit(&island->evolution->stop, memory_order_relaxed))
+			return;
+		game_step_with_table(game, decisions);
+	}
+
+	size_t best_agent_index = 0;
+	size_t lifetime_sum = 0;
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		lifetime_sum += game->agents[i].lifetime;
+		if (game->agents[i].lifetime > game->agents[best_agent_index].lifetime)
+			best_agent_index = i;
+	}
+
+	// game_step never reorders agents, so the slot is the same in `start`.
+	evolution_report(island->evolution,
+			 island,
+			 best_agent_index,
+			 game->agents[best_agent_index].lifetime,
+			 (float)lifetime_sum / AGENTS_COUNT);
+
+	int next = 1 - island->current_game;
+	prepare_next_game(game, &island->games[next]);
+	island->current_game = next;
+	island->generation += 1;
+}
+
+void evolution_report(Evolution *evolution,
+		      const Island *island,
+		      size_t best_agent_index,
+		      size_t best_lifetime,
+		      float mean_lifetime) {
+	pthread_mutex_lock(&evolution->mutex);
+
+	evolution->generations_done += 1;
+	evolution_record_history(evolution, island->generation, (float)best_lifetime, mean_lifetime);
+
+	// `>=` keeps the replay fresh once the best lifetime plateaus.
+	if (best_lifetime >= evolution->best_lifetime) {
+		memcpy(&evolution->best_start, &island->start, sizeof(evolution->best_start));
+		evolution->best_generation = island->generation;
+		evolution->best_agent_index = best_agent_index;
+		evolution->best_lifetime = best_lifetime;
+		atomic_fetch_add(&evolution->best_version, 1);
+	}
+
+	pthread_mutex_unlock(&evolution->mutex);
+}
+
+// The history covers the whole run: once it's full, neighbouring buckets are merged
+// and every bucket starts covering twice as many generations.
+void evolution_record_history(Evolution *evolution, size_t generation, float best, float mean) {
+	while (generation / evolution->history_stride >= EVOLUTION_HISTORY_CAPACITY) {
+		for (size_t i = 0; i < EVOLUTION_HISTORY_CAPACITY / 2; ++i) {
+			const FitnessSample *a = &evolution->history[2 * i];
+			const FitnessSample *b = &evolution->history[2 * i + 1];
+			FitnessSample merged = {
+				a->best > b->best ? a->best : b->best,
+				a->mean_sum + b->mean_sum,
+				a->count + b->count,
+			};
+			evolution->history[i] = merged;
+		}
+		memset(&evolution->history[EVOLUTION_HISTORY_CAPACITY / 2],
+		       0,
+		       sizeof(FitnessSample) * (EVOLUTION_HISTORY_CAPACITY / 2));
+		evolution->history_stride *= 2;
+		evolution->history_count = (evolution->history_count + 1) / 2;
+	}
+
+	size_t bucket = generation / evolution->history_stride;
+	FitnessSample *sample = &evolution->history[bucket];
+	if (best > sample->best)
+		sample->best = best;
+	sample->mean_sum += mean;
+	sample->count += 1;
+
+	if (bucket + 1 > evolution->history_count)
+		evolution->history_count = bucket + 1;
+}
@@ -0,0 +1,62 @@
+#ifndef EVOLUTION_H
+#define EVOLUTION_H
+
+#include "game.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define EVOLUTION_MAX_ISLANDS 8
+#define EVOLUTION_HISTORY_CAPACITY 512 // has to be an even number
+
+// Fitness of a bucket of `history_stride` generations, folded across all islands.
+typedef struct {
+	float best;
+	float mean_sum;
+	size_t count;
+} FitnessSample;
+
+struct Evolution;
+
+// Every island is an independent population evolving on its own thread
+// with the regular game_step/prepare_next_game engine.
+typedef struct {
+	struct Evolution *evolution;
+	pthread_t thread;
+	unsigned int seed;
+	int current_game;
+	size_t generation;
+	Game games[2];
+	Game start; // how the current generation looked before the first tick, used for replays
+} Island;
+
+typedef struct Evolution {
+	atomic_bool stop;
+	atomic_size_t best_version; // bumped every time `best_start` is replaced
+	size_t islands_count;
+	Island islands[EVOLUTION_MAX_ISLANDS];
+
+	// Guards everything below. It's only taken once per finished generation and by readers.
+	pthread_mutex_t mutex;
+	Game best_start;
+	size_t best_generation;
+	size_t best_agent_index;
+	size_t best_lifetime;
+	size_t generations_done;
+	size_t history_count;
+	size_t history_stride;
+	FitnessSample history[EVOLUTION_HISTORY_CAPACITY];
+} Evolution;
+
+Evolution *evolution_start(const Game *seed_game, size_t islands_count, unsigned int seed);
+void evolution_stop(Evolution *evolution);
+size_t evolution_default_islands_count(void);
+
+size_t evolution_best_version(Evolution *evolution);
+size_t evolution_generations_done(Evolution *evolution);
+bool evolution_copy_best(Evolution *evolution, Game *out, size_t *generation, size_t *best_agent_index);
+size_t evolution_copy_history(Evolution *evolution, float *best, float *mean, size_t capacity);
+
+#endif // !EVOLUTION_H
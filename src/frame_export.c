@@ -0,0 +1,274 @@
+#include "frame_export.h"
+
+#include "buffered_writer.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xC0
+#define QOI_OP_RGB 0xFE
+#define QOI_MAX_RUN 62
+
+void *frame_encoder_thread(void *arg);
+bool frame_write(FrameExporter *exporter, const char *filepath);
+void frame_write_ppm(BufferedWriter *writer, const Raster *raster);
+void frame_write_qoi(BufferedWriter *writer, const Raster *raster);
+void write_u32_big_endian(BufferedWriter *writer, uint32_t value);
+
+bool frame_format_parse(const char *name, FrameFormat *out) {
+	for (int format = 0; format < FF_COUNT; ++format) {
+		if (strcmp(name, frame_format_extension((FrameFormat)format)) == 0) {
+			*out = (FrameFormat)format;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const char *frame_format_extension(FrameFormat format) {
+	switch (format) {
+	case FF_PPM: return "ppm";
+	case FF_QOI: return "qoi";
+	case FF_COUNT:
+	default: return "unknown";
+	}
+}
+
+FrameExporter *frame_exporter_start(const char *directory, FrameFormat format, size_t cell_size) {
+	if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "ERROR: Couldn't create the frames directory %s: %s.\n", directory, strerror(errno));
+		return NULL;
+	}
+
+	FrameExporter *exporter = calloc(1, sizeof(*exporter));
+	if (exporter == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate the frame exporter.\n");
+		return NULL;
+	}
+
+	if (strlen(directory) >= sizeof(exporter->directory)) {
+		fprintf(stderr, "ERROR: The frames directory path is too long.\n");
+		free(exporter);
+		return NULL;
+	}
+
+	strcpy(exporter->directory, directory);
+	exporter->format = format;
+	if (!raster_init(&exporter->raster, cell_size)) {
+		free(exporter);
+		return NULL;
+	}
+
+	pthread_mutex_init(&exporter->mutex, NULL);
+	pthread_cond_init(&exporter->not_empty, NULL);
+	pthread_cond_init(&exporter->not_full, NULL);
+
+	if (pthread_create(&exporter->thread, NULL, frame_encoder_thread, exporter) != 0) {
+		fprintf(stderr, "ERROR: Couldn't start the frame encoder thread.\n");
+		pthread_cond_destroy(&exporter->not_full);
+		pthread_cond_destroy(&exporter->not_empty);
+		pthread_mutex_destroy(&exporter->mutex);
+		raster_free(&exporter->raster);
+		free(exporter);
+		return NULL;
+	}
+
+	return exporter;
+}
+
+void frame_exporter_submit(FrameExporter *exporter, const Game *game, uint64_t generation, uint64_t tick) {
+	pthread_mutex_lock(&exporter->mutex);
+
+	if (exporter->count == FRAME_EXPORT_QUEUE_CAPACITY) {
+		exporter->stalls += 1;
+		while (exporter->count == FRAME_EXPORT_QUEUE_CAPACITY)
+			pthread_cond_wait(&exporter->not_full, &exporter->mutex);
+	}
+
+	size_t tail = (exporter->head + exporter->count) % FRAME_EXPORT_QUEUE_CAPACITY;
+	raster_scene_capture(&exporter->queue[tail], game, generation, tick);
+	exporter->count += 1;
+
+	pthread_cond_signal(&exporter->not_empty);
+	pthread_mutex_unlock(&exporter->mutex);
+}
+
+bool frame_exporter_stop(FrameExporter *exporter) {
+	if (exporter == NULL)
+		return false;
+
+	pthread_mutex_lock(&exporter->mutex);
+	exporter->stop = true;
+	pthread_cond_signal(&exporter->not_empty);
+	pthread_mutex_unlock(&exporter->mutex);
+	pthread_join(exporter->thread, NULL);
+
+	bool result = !exporter->failed;
+	fprintf(stdout,
+		"INFO: %zu frames written into %s, waited for the encoder %zu times.\n",
+		exporter->frames_written,
+		exporter->directory,
+		exporter->stalls);
+
+	pthread_cond_destroy(&exporter->not_full);
+	pthread_cond_destroy(&exporter->not_empty);
+	pthread_mutex_destroy(&exporter->mutex);
+	raster_free(&exporter->raster);
+	free(exporter);
+	return result;
+}
+
+// Drains the queue even after a stop request, only an empty queue ends it.
+void *frame_encoder_thread(void *arg) {
+	FrameExporter *exporter = arg;
+	RasterScene scene;
+	char filepath[FRAME_EXPORT_PATH_CAPACITY + 32]; // room for the name of the frame
+
+	for (;;) {
+		pthread_mutex_lock(&exporter->mutex);
+		while (exporter->count == 0 && !exporter->stop)
+			pthread_cond_wait(&exporter->not_empty, &exporter->mutex);
+
+		if (exporter->count == 0) {
+			pthread_mutex_unlock(&exporter->mutex);
+			break;
+		}
+
+		memcpy(&scene, &exporter->queue[exporter->head], sizeof(scene));
+		exporter->head = (exporter->head + 1) % FRAME_EXPORT_QUEUE_CAPACITY;
+		exporter->count -= 1;
+		pthread_cond_signal(&exporter->not_full);
+		pthread_mutex_unlock(&exporter->mutex);
+
+		// Keep emptying the queue after a failure, the trainer must not wait for a broken encoder.
+		if (exporter->failed)
+			continue;
+
+		raster_draw_scene(&exporter->raster, &scene);
+		snprintf(filepath,
+			 sizeof(filepath),
+			 "%s/frame_%08zu.%s",
+			 exporter->directory,
+			 exporter->frames_written,
+			 frame_format_extension(exporter->format));
+
+		if (!frame_write(exporter, filepath)) {
+			fprintf(stderr, "ERROR: Couldn't write %s, no more frames will be written.\n", filepath);
+			exporter->failed = true;
+			continue;
+		}
+
+		exporter->frames_written += 1;
+	}
+
+	return NULL;
+}
+
+bool frame_write(FrameExporter *exporter, const char *filepath) {
+	BufferedWriter *writer = malloc(sizeof(*writer));
+	if (writer == NULL || !buffered_writer_open(writer, filepath)) {
+		free(writer);
+		return false;
+	}
+
+	switch (exporter->format) {
+	case FF_PPM: frame_write_ppm(writer, &exporter->raster); break;
+	case FF_QOI: frame_write_qoi(writer, &exporter->raster); break;
+	case FF_COUNT:
+	default: break;
+	}
+
+	bool result = buffered_writer_close(writer);
+	free(writer);
+	return result;
+}
+
+void frame_write_ppm(BufferedWriter *writer, const Raster *raster) {
+	buffered_writer_printf(writer, "P6\n%zu %zu\n255\n", raster->width, raster->height);
+
+	for (size_t i = 0; i < raster->width * raster->height; ++i) {
+		uint32_t pixel = raster->pixels[i];
+		buffered_writer_write_u8(writer, (uint8_t)(pixel >> 16));
+		buffered_writer_write_u8(writer, (uint8_t)(pixel >> 8));
+		buffered_writer_write_u8(writer, (uint8_t)pixel);
+	}
+}
+
+// https://qoiformat.org/qoi-specification.pdf, RGB since frames are opaque.
+void frame_write_qoi(BufferedWriter *writer, const Raster *raster) {
+	uint32_t seen[64] = { 0 };
+	uint32_t previous = 0xFF000000;
+	size_t run = 0;
+	size_t pixels_count = raster->width * raster->height;
+
+	buffered_writer_write(writer, "qoif", 4);
+	write_u32_big_endian(writer, (uint32_t)raster->width);
+	write_u32_big_endian(writer, (uint32_t)raster->height);
+	buffered_writer_write_u8(writer, 3); // channels
+	buffered_writer_write_u8(writer, 0); // sRGB with linear alpha
+
+	for (size_t i = 0; i < pixels_count; ++i) {
+		uint32_t pixel = raster->pixels[i];
+
+		if (pixel == previous) {
+			run += 1;
+			if (run == QOI_MAX_RUN || i == pixels_count - 1) {
+				buffered_writer_write_u8(writer, (uint8_t)(QOI_OP_RUN | (run - 1)));
+				run = 0;
+			}
+			continue;
+		}
+
+		if (run > 0) {
+			buffered_writer_write_u8(writer, (uint8_t)(QOI_OP_RUN | (run - 1)));
+			run = 0;
+		}
+
+		uint32_t r = (pixel >> 16) & 0xFF, g = (pixel >> 8) & 0xFF, b = pixel & 0xFF;
+		uint32_t hash = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+
+		if (seen[hash] == pixel) {
+			buffered_writer_write_u8(writer, (uint8_t)(QOI_OP_INDEX | hash));
+		} else {
+			seen[hash] = pixel;
+
+			// Differences wrap around, so they are computed in 8 bits.
+			int dr = (int8_t)(uint8_t)(r - ((previous >> 16) & 0xFF));
+			int dg = (int8_t)(uint8_t)(g - ((previous >> 8) & 0xFF));
+			int db = (int8_t)(uint8_t)(b - (previous & 0xFF));
+			int dr_dg = dr - dg;
+			int db_dg = db - dg;
+
+			if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+				buffered_writer_write_u8(writer, (uint8_t)(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+			} else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+				buffered_writer_write_u8(writer, (uint8_t)(QOI_OP_LUMA | (dg + 32)));
+				buffered_writer_write_u8(writer, (uint8_t)((dr_dg + 8) << 4 | (db_dg + 8)));
+			} else {
+				buffered_writer_write_u8(writer, QOI_OP_RGB);
+				buffered_writer_write_u8(writer, (uint8_t)r);
+				buffered_writer_write_u8(writer, (uint8_t)g);
+				buffered_writer_write_u8(writer, (uint8_t)b);
+			}
+		}
+
+		previous = pixel;
+	}
+
+	static const uint8_t END_MARKER[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+	buffered_writer_write(writer, END_MARKER, sizeof(END_MARKER));
+}
+
+void write_u32_big_endian(BufferedWriter *writer, uint32_t value) {
+	buffered_writer_write_u8(writer, (uint8_t)(value >> 24));
+	buffered_writer_write_u8(writer, (uint8_t)(value >> 16));
+	buffered_writer_write_u8(writer, (uint8_t)(value >> 8));
+	buffered_writer_write_u8(writer, (uint8_t)value);
+}
@@ -0,0 +1,53 @@
+#ifndef FRAME_EXPORT_H
+#define FRAME_EXPORT_H
+
+#include "game.h"
+#include "raster.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FRAME_EXPORT_QUEUE_CAPACITY 32
+#define FRAME_EXPORT_PATH_CAPACITY 512
+
+typedef enum {
+	FF_PPM = 0, // binary P6, big but readable by anything
+	FF_QOI, // "Quite OK Image" format, lossless and several times smaller on boards like these
+	FF_COUNT,
+} FrameFormat;
+
+// Frames go through a bounded queue of scenes to a thread that draws and encodes them into
+// `<directory>/frame_00000000.<format>`, numbered in the order they were submitted.
+// The caller only copies a scene; it waits only when the encoder is a whole queue behind.
+typedef struct {
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+	bool stop; // guarded by `mutex` like the queue
+	size_t head;
+	size_t count;
+	RasterScene queue[FRAME_EXPORT_QUEUE_CAPACITY];
+
+	// Only the encoder thread touches these until it's joined.
+	char directory[FRAME_EXPORT_PATH_CAPACITY];
+	FrameFormat format;
+	Raster raster;
+	size_t frames_written;
+	bool failed;
+
+	size_t stalls; // submits that had to wait for a free slot
+} FrameExporter;
+
+bool frame_format_parse(const char *name, FrameFormat *out);
+const char *frame_format_extension(FrameFormat format);
+
+// Creates `directory` if it isn't there. Returns NULL when it can't be created or the thread can't start.
+FrameExporter *frame_exporter_start(const char *directory, FrameFormat format, size_t cell_size);
+void frame_exporter_submit(FrameExporter *exporter, const Game *game, uint64_t generation, uint64_t tick);
+// Waits for every submitted frame to be written, returns false when some of them couldn't be.
+bool frame_exporter_stop(FrameExporter *exporter);
+
+#endif // !FRAME_EXPORT_H
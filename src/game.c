@@ -1,7 +1,8 @@
 #include "game.h"
-#include "style.h"
+#include "event_log.h"
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,6 +10,16 @@
 static_assert(AGENTS_COUNT + FOOD_COUNT + WALLS_COUNT <= BOARD_WIDTH * BOARD_HEIGHT,
 	      "Too many entities. You won't be able to fit all of them on game board.");
 static_assert(GENES_COUNT % 2 == 0, "Genes count has to be an even number for proper work of evolution.");
+static_assert(MAX_LIFETIME <= UINT16_MAX, "Gene usage counters are 16 bits wide.");
+static_assert(GENES_COUNT <= UINT8_MAX, "Decision tables store gene indices in a byte.");
+
+// The tick is written once as game_step_kernel and stamped out for every way it's run. Arguments that
+// are constant at a call site fold away, so no variant pays for the branches of the others.
+#if defined(__GNUC__)
+#define GAME_KERNEL static inline __attribute__((always_inline))
+#else
+#define GAME_KERNEL static inline
+#endif
 
 Position position_directions[4] = {
 	{ 1, 0 }, // DIR_RIGHT
@@ -17,6 +28,50 @@ Position position_directions[4] = {
 	{ 0, 1 }, // DIR_DOWN
 };
 
+// Quarter turns counterclockwise every action makes, directions are numbered that way.
+const unsigned int action_quarter_turns[AA_COUNT] = {
+	0, // AA_NOTHING
+	0, // AA_STEP
+	1, // AA_TURN_LEFT
+	3, // AA_TURN_RIGHT
+};
+
+const VerboseAction action_outcomes[AA_COUNT] = {
+	VA_NOTHING, // AA_NOTHING
+	VA_STEP, // AA_STEP
+	VA_TURN_LEFT, // AA_TURN_LEFT
+	VA_TURN_RIGHT, // AA_TURN_RIGHT
+};
+
+// Where an agent of the previous game ranks, see prepare_next_game.
+typedef struct {
+	size_t lifetime;
+	bool alive;
+	size_t index;
+} AgentRank;
+
+#define BOARD_CELL_EMPTY -1
+#define BOARD_CELL_SHARED -2
+
+static_assert(AGENTS_COUNT <= UINT8_MAX && FOOD_COUNT <= INT16_MAX, "Board index counters are too narrow.");
+
+// Where everything is for the duration of one tick, so that sensing and stepping look a cell
+// up instead of scanning every entity on the board.
+//
+// Food and walls never move: a cell keeps the index of the food on it. Only alive agents are
+// counted and the index of one is kept while it's alone on the cell. Cells with more than one
+// food or agent fall back to the scans the reference engine does, so the lowest index still wins.
+typedef struct {
+	int16_t food[BOARD_HEIGHT][BOARD_WIDTH];
+	bool wall[BOARD_HEIGHT][BOARD_WIDTH];
+	uint8_t agents_count[BOARD_HEIGHT][BOARD_WIDTH];
+	int16_t agent[BOARD_HEIGHT][BOARD_WIDTH];
+} BoardIndex;
+
+// Every thread has its own generator, so threads running their own games neither fight over
+// nor reorder each other's random sequences the way they would with the shared `rand()` state.
+_Thread_local uint64_t random_state = 0x9E3779B97F4A7C15ull;
+
 VerboseAction agent_action_as_verbose_action(AgentAction aa);
 
 const char *env_as_cstr(Environment env);
@@ -26,28 +81,29 @@ const char *direction_as_cstr(Direction d);
 
 bool positions_are_equal(Position first, Position second);
 bool is_cell_empty(const Game *game, Position pos);
+int wrap_coordinate(int value, int size);
+size_t first_matching_gene(const Chromosome *chromosome, AgentState state, Environment environment);
 
-int random_int_range(int low, int high);
+uint32_t random_next(void);
 Direction random_direction(void);
 Position random_position(void);
-Position random_empty_position(const Game *game);
 Environment random_environment(void);
 AgentAction random_action(void);
 
-void initialize_basic_agent_properties(Game *game, Agent *agent, size_t agent_index);
-void initialize_gene(Gene *gene);
 void initialize_food(Game *game);
 void initialize_walls(Game *game);
 
-void move_agent(Agent *agent);
+void board_index_build(BoardIndex *index, const Game *game);
+void board_index_add_agent(BoardIndex *index, const Game *game, size_t agent_index);
+void board_index_remove_agent(BoardIndex *index, const Game *game, size_t agent_index);
+Food *board_index_food_at(const BoardIndex *index, Game *game, Position pos);
+Agent *board_index_agent_at(const BoardIndex *index, Game *game, Position pos);
+bool board_index_wall_at(const BoardIndex *index, Position pos);
 
-Environment interpret_environment_infront_of_agent(Game *game, Agent *agent);
-void execute_action(Game *game, Agent *agent, AgentAction action);
+Environment sense_environment(const BoardIndex *index, Game *game, Position infront);
+VerboseAction execute_action(Game *game, BoardIndex *index, Agent *agent, AgentAction action, size_t *target_index);
 
-void mate_agents(const Agent *parent_a, const Agent *parent_b, Agent *child);
-void mutate_agent(Agent *agent);
-int agent_lifetime_comparator(const void *a, const void *b);
-void prepare_next_generation(Game *previous_game, Game *next_game);
+int agent_rank_comparator(const void *a, const void *b);
 
 void print_gene(FILE *stream, const Gene *gene, size_t agent_index, size_t gene_index) {
 	fprintf(stream,
@@ -78,7 +134,7 @@ void print_agent(FILE *stream, const Agent *a) {
 		a->health);
 }
 
-void print_agent_verbose(FILE *stream, const Agent *a) {
+void print_agent_verbose(FILE *stream, const Agent *a, const Chromosome *chromosome) {
 	fprintf(stream, "\nagent:      {\n");
 	fprintf(stream, "\tindex:      %zu\n", a->index);
 	fprintf(stream, "\tpos:        [%d;%d]\n", a->pos.x, a->pos.y);
@@ -87,14 +143,21 @@ void print_agent_verbose(FILE *stream, const Agent *a) {
 	fprintf(stream, "\thunger:     %d\n", a->hunger);
 	fprintf(stream, "\thealth:     %d\n", a->health);
 	fprintf(stream, "\tlifetime:   %zu\n", a->lifetime);
+	fprintf(stream, "\tdeath:      %s\n", death_cause_as_cstr(a->death_cause));
+	fprintf(stream, "\tfood eaten: %zu\n", a->food_eaten);
+	fprintf(stream, "\tattacks:    %zu dealt, %zu received\n", a->attacks_dealt, a->attacks_received);
+#if GAME_RECORD_HISTORY
 	fprintf(stream, "\thistory:    {\n");
 	for (size_t i = 0; i < a->lifetime; ++i) {
 		fprintf(stream, "\t\t%3zu action:    %s\n", i, verbose_action_as_cstr(a->action_history[i]));
 		fprintf(stream, "\t\t%3zu gene:      %d\n", i, a->used_genes_history[i]);
 	}
 	fprintf(stream, "\t}\n");
+#else
+	fprintf(stream, "\thistory:    not recorded, use the event log replay\n");
+#endif
 	fprintf(stream, "\tchromosome:    {\n");
-	print_chromosome(stream, &a->chromosome, a->index);
+	print_chromosome(stream, chromosome, a->index);
 	fprintf(stream, "\t}\n");
 	fprintf(stream, "}\n");
 }
@@ -105,7 +168,7 @@ void print_the_state_of_oldest_agent(Game *game) {
 		if (game->agents[i].lifetime > oldest_agent->lifetime)
 			oldest_agent = &game->agents[i];
 	}
-	print_agent_verbose(stdout, oldest_agent);
+	print_agent_verbose(stdout, oldest_agent, &game->genomes[oldest_agent - game->agents]);
 }
 
 Food *get_ptr_to_food_infront_of_agent(Game *game, Agent *agent) {
@@ -174,7 +237,7 @@ void initialize_game(Game *game) {
 		initialize_basic_agent_properties(game, &game->agents[i], i);
 
 		for (size_t j = 0; j < GENES_COUNT; ++j) {
-			initialize_gene(&game->agents[i].chromosome.genes[j]);
+			initialize_gene(&game->genomes[i].genes[j]);
 		}
 	}
 
@@ -182,38 +245,63 @@ void initialize_game(Game *game) {
 	initialize_walls(game);
 }
 
-void game_step(Game *game) {
+// `log` and `table` are optional. With a log, every action and death of this tick ends up in it.
+// With a table, genes are looked up in it instead of being scanned.
+//
+// The rules are defined by game_step_reference (see game_reference.c), `trainer --verify` checks
+// that both engines agree after every tick.
+GAME_KERNEL void game_step_kernel(Game *game, EventLog *log, const DecisionTable *table) {
+	BoardIndex index;
+	board_index_build(&index, game);
+
+	if (log != NULL)
+		event_log_begin_tick(log);
+
 	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
 		Agent *agent = &game->agents[i];
 
 		if (agent->health <= 0)
 			continue;
 
-		agent->lifetime += 1;
-
-		if (agent->lifetime == MAX_LIFETIME) {
-			fprintf(stdout, "Agent managed to die of old age!\n");
-			agent->health = 0;
+		if (!age_agent(agent)) {
+			// Counted as DC_OLD_AGE in the generation statistics, nothing is printed from here.
+			board_index_remove_agent(&index, game, i);
+			if (log != NULL)
+				event_log_death(log, i, DC_OLD_AGE);
 			continue;
 		}
 
-		for (size_t j = 0; j < GENES_COUNT; ++j) {
-			Gene *gene = &game->agents[i].chromosome.genes[j];
-
-			if (gene->current_state != agent->current_state)
-				continue;
-
-			if (gene->environment != interpret_environment_infront_of_agent(game, agent))
-				continue;
-
-			// qm_todo: with this approach I favor genes with lover indexes, while
-			// there might be several genes with the same state.
-			// Maybe I should select a pool of all genes that match the preconditions
-			// and execute an action from a random one?
-			execute_action(game, agent, gene->action);
-			agent->used_genes_history[agent->lifetime] = (int)j;
-			agent->current_state = gene->next_state;
-			break;
+		// Nothing in front of the agent changes until it acts, it's sensed once rather than once per gene.
+		Environment environment = sense_environment(&index, game, get_position_infront_of_agent(agent));
+
+		// qm_todo: with this approach I favor genes with lover indexes, while
+		// there might be several genes with the same state.
+		// Maybe I should select a pool of all genes that match the preconditions
+		// and execute an action from a random one?
+		size_t j = table != NULL ? table->first_gene[i][agent->current_state][environment] :
+					   first_matching_gene(&game->genomes[i], agent->current_state, environment);
+		if (j == GENES_COUNT)
+			continue;
+
+		const Gene *gene = &game->genomes[i].genes[j];
+		Position position_before = agent->pos;
+		size_t target_index = 0;
+		VerboseAction outcome = execute_action(game, &index, agent, gene->action, &target_index);
+		agent->gene_usage[j] += 1;
+#if GAME_RECORD_HISTORY
+		agent->used_genes_history[agent->lifetime] = (int)j;
+#endif
+		agent->current_state = gene->next_state;
+
+		if (log != NULL) {
+			bool moved = !positions_are_equal(position_before, agent->pos);
+			event_log_action(log, i, j, outcome, moved, target_index);
+
+			// An attack is the only thing that can kill during the action phase.
+			if (outcome == VA_ATTACK && game->agents[target_index].health <= 0)
+				event_log_death(log, target_index, DC_COMBAT);
+			if (outcome == VA_ATTACK && agent->health <= 0)
+				event_log_death(log, i, DC_COMBAT);
 		}
 	}
 
@@ -221,25 +309,140 @@ void game_step(Game *game) {
 		if (game->agents[i].health <= 0)
 			continue;
 
-		if (game->agents[i].hunger >= LETHAL_HUNGER) {
-			game->agents[i].hunger = LETHAL_HUNGER;
-			game->agents[i].health -= HUNGER_TICK;
-			continue;
+		starve_agent(&game->agents[i]);
+
+		if (log != NULL && game->agents[i].health <= 0)
+			event_log_death(log, i, DC_HUNGER);
+	}
+
+	if (log != NULL)
+		event_log_end_tick(log, game);
+}
+
+void game_step(Game *game) {
+	game_step_kernel(game, NULL, NULL);
+}
+
+void game_step_logged(Game *game, EventLog *log) {
+	if (log == NULL) {
+		game_step_kernel(game, NULL, NULL);
+		return;
+	}
+
+	game_step_kernel(game, log, NULL);
+}
+
+void game_step_with_table(Game *game, const DecisionTable *table) {
+	if (table == NULL) {
+		game_step_kernel(game, NULL, NULL);
+		return;
+	}
+
+	game_step_kernel(game, NULL, table);
+}
+
+// The lowest index wins, like in the scan it replaces.
+const DecisionTable *decision_table_build(DecisionTable *table, const Game *game) {
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		const Agent *agent = &game->agents[i];
+
+		// States the table has no row for are left to the scan, which only ever compares them.
+		if (agent->health > 0 && agent->current_state >= STATES_COUNT)
+			return NULL;
+
+		memset(table->first_gene[i], GENES_COUNT, sizeof(table->first_gene[i]));
+		for (size_t j = GENES_COUNT; j-- > 0;) {
+			const Gene *gene = &game->genomes[i].genes[j];
+
+			if (gene->current_state >= STATES_COUNT || gene->next_state >= STATES_COUNT || gene->environment >= ENV_COUNT)
+				return NULL;
+
+			table->first_gene[i][gene->current_state][gene->environment] = (uint8_t)j;
 		}
+	}
+
+	return table;
+}
+
+size_t first_matching_gene(const Chromosome *chromosome, AgentState state, Environment environment) {
+	for (size_t j = 0; j < GENES_COUNT; ++j) {
+		const Gene *gene = &chromosome->genes[j];
 
-		game->agents[i].hunger += HUNGER_TICK;
+		if (gene->current_state == state && gene->environment == environment)
+			return j;
 	}
+
+	return GENES_COUNT;
 }
 
-VerboseAction agent_action_as_verbose_action(AgentAction aa) {
-	switch (aa) {
-	case AA_NOTHING: return VA_NOTHING;
-	case AA_STEP: return VA_STEP;
-	case AA_TURN_LEFT: return VA_TURN_LEFT;
-	case AA_TURN_RIGHT: return VA_TURN_RIGHT;
-	case AA_COUNT:
-	default: assert(0 && "That's not supposed to happen."); return VA_COUNT;
+// Returns false when the agent just died of old age and can't act anymore.
+bool age_agent(Agent *agent) {
+	agent->lifetime += 1;
+
+	if (agent->lifetime == MAX_LIFETIME) {
+		agent->health = 0;
+		agent->death_cause = DC_OLD_AGE;
+		return false;
 	}
+
+#if GAME_RECORD_HISTORY
+	// Game buffers are reused without clearing, a tick where no gene fires must still read as nothing.
+	agent->action_history[agent->lifetime] = VA_NOTHING;
+	agent->used_genes_history[agent->lifetime] = 0;
+#endif
+
+	return true;
+}
+
+void feed_agent(Agent *agent, Food *food) {
+	food->quantity -= 1;
+	agent->hunger -= FOOD_HUNGER_RECOVERY;
+	agent->food_eaten += 1;
+
+	if (agent->hunger < 0)
+		agent->hunger = 0;
+
+	// in case of food quantity == 1 on initialization,
+	// I can experiment with occupying the tile after eating the food.
+	move_agent(agent);
+}
+
+void attack_agent(Agent *attacker, Agent *victim) {
+	victim->health -= ATTACK_DMG;
+	victim->hunger += HUNGER_TICK;
+	if (victim->hunger > LETHAL_HUNGER)
+		victim->hunger = LETHAL_HUNGER;
+
+	attacker->health -= RETALIATION_DMG;
+	attacker->hunger -= HUNGER_TICK;
+
+	attacker->attacks_dealt += 1;
+	victim->attacks_received += 1;
+
+	// No check for negative hp here.
+	// We perform all actions first, then declare dead agents.
+	if (victim->health <= 0)
+		victim->death_cause = DC_COMBAT;
+	if (attacker->health <= 0)
+		attacker->death_cause = DC_COMBAT;
+}
+
+void starve_agent(Agent *agent) {
+	if (agent->hunger >= LETHAL_HUNGER) {
+		agent->hunger = LETHAL_HUNGER;
+		agent->health -= HUNGER_TICK;
+
+		if (agent->health <= 0)
+			agent->death_cause = DC_HUNGER;
+		return;
+	}
+
+	agent->hunger += HUNGER_TICK;
+}
+
+VerboseAction agent_action_as_verbose_action(AgentAction aa) {
+	assert(aa >= AA_NOTHING && aa < AA_COUNT && "That's not supposed to happen.");
+	return action_outcomes[aa];
 }
 
 const char *env_as_cstr(Environment env) {
@@ -277,12 +480,24 @@ const char *verbose_action_as_cstr(VerboseAction va) {
 	}
 }
 
+const char *death_cause_as_cstr(DeathCause dc) {
+	switch (dc) {
+	case DC_ALIVE: return "DC_ALIVE";
+	case DC_HUNGER: return "DC_HUNGER";
+	case DC_COMBAT: return "DC_COMBAT";
+	case DC_OLD_AGE: return "DC_OLD_AGE";
+	case DC_COUNT:
+	default: assert(0 && "That's not supposed to happen."); return NULL;
+	}
+}
+
 const char *direction_as_cstr(Direction d) {
 	switch (d) {
 	case DIR_RIGHT: return "DIR_RIGHT";
 	case DIR_UP: return "DIR_UP";
 	case DIR_LEFT: return "DIR_LEFT";
 	case DIR_DOWN: return "DIR_DOWN";
+	default: assert(0 && "That's not supposed to happen."); return NULL;
 	}
 }
 
@@ -310,8 +525,24 @@ bool is_cell_empty(const Game *game, Position pos) {
 	return true;
 }
 
+void seed_random(unsigned int seed) {
+	// splitmix64, so that neighbouring seeds don't start neighbouring sequences.
+	uint64_t z = (uint64_t)seed + 0x9E3779B97F4A7C15ull;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	random_state = (z ^ (z >> 31)) | 1;
+}
+
+// xorshift64*
+uint32_t random_next(void) {
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+	return (uint32_t)((random_state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
 int random_int_range(int low, int high) {
-	return rand() % (high - low) + low;
+	return (int)(random_next() % (uint32_t)(high - low)) + low;
 }
 
 Direction random_direction(void) {
@@ -319,7 +550,7 @@ Direction random_direction(void) {
 }
 
 Position random_position(void) {
-	Position result = { random_int_range(0, BOARD_WIDTH), random_int_range(0, BOARD_HEIGHT) };
+	Position result = { (int16_t)random_int_range(0, BOARD_WIDTH), (int16_t)random_int_range(0, BOARD_HEIGHT) };
 
 	return result;
 }
@@ -346,10 +577,10 @@ AgentAction random_action(void) {
 }
 
 void initialize_gene(Gene *gene) {
-	gene->current_state = random_int_range(0, STATES_COUNT);
-	gene->environment = random_environment();
-	gene->action = random_action();
-	gene->next_state = random_int_range(0, STATES_COUNT);
+	gene->current_state = (AgentState)random_int_range(0, STATES_COUNT);
+	gene->environment = (uint8_t)random_environment();
+	gene->action = (uint8_t)random_action();
+	gene->next_state = (AgentState)random_int_range(0, STATES_COUNT);
 }
 
 void initialize_basic_agent_properties(Game *game, Agent *agent, size_t agent_index) {
@@ -359,8 +590,17 @@ void initialize_basic_agent_properties(Game *game, Agent *agent, size_t agent_in
 	agent->hunger = STARTING_HUNGER;
 	agent->health = STARTING_HEALTH;
 	agent->lifetime = 0;
+	agent->death_cause = DC_ALIVE;
+	agent->food_eaten = 0;
+	agent->attacks_dealt = 0;
+	agent->attacks_received = 0;
+	memset(agent->gene_usage, 0, sizeof(agent->gene_usage));
+#if GAME_RECORD_HISTORY
 	agent->action_history[0] = VA_NOTHING;
 	agent->used_genes_history[0] = -1;
+#endif
+
+	agent->current_state = 0;
 
 	// qm_todo: improve this later.
 	agent->direction = agent_index % 4;
@@ -383,132 +623,236 @@ int mod_int(int first, int second) {
 	return (first % second + second) % second;
 }
 
-void move_agent(Agent *agent) {
-	Position delta = position_directions[agent->direction];
+// Agents move one cell at a time, so wrapping around the board takes a compare instead of the two
+// divisions of mod_int. A side that is a power of two takes a mask, `size` is a constant everywhere
+// this is called from, so the choice is made at compile time.
+int wrap_coordinate(int value, int size) {
+	if ((size & (size - 1)) == 0)
+		return value & (size - 1);
 
-	agent->pos.x = mod_int(agent->pos.x + delta.x, BOARD_WIDTH);
-	agent->pos.y = mod_int(agent->pos.y + delta.y, BOARD_HEIGHT);
+	if (value < 0)
+		return value + size;
+	if (value >= size)
+		return value - size;
+	return value;
+}
+
+void move_agent(Agent *agent) {
+	agent->pos = get_position_infront_of_agent(agent);
 }
 
 Position get_position_infront_of_agent(const Agent *agent) {
 	Position delta = position_directions[agent->direction];
 	Position next = agent->pos;
 
-	next.x = mod_int(next.x + delta.x, BOARD_WIDTH);
-	next.y = mod_int(next.y + delta.y, BOARD_HEIGHT);
+	next.x = (int16_t)wrap_coordinate(next.x + delta.x, BOARD_WIDTH);
+	next.y = (int16_t)wrap_coordinate(next.y + delta.y, BOARD_HEIGHT);
 
 	return next;
 }
 
-Environment interpret_environment_infront_of_agent(Game *game, Agent *agent) {
-	// This order kind of serves as priority list.
+void board_index_build(BoardIndex *index, const Game *game) {
+	// All bits set is -1, BOARD_CELL_EMPTY.
+	memset(index->food, 0xFF, sizeof(index->food));
+	memset(index->wall, 0, sizeof(index->wall));
+	memset(index->agents_count, 0, sizeof(index->agents_count));
+	memset(index->agent, 0xFF, sizeof(index->agent));
 
-	if (get_ptr_to_food_infront_of_agent(game, agent) != NULL)
-		return ENV_FOOD;
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		Position pos = game->food[i].pos;
+		int16_t *cell = &index->food[pos.y][pos.x];
+		*cell = *cell == BOARD_CELL_EMPTY ? (int16_t)i : BOARD_CELL_SHARED;
+	}
 
-	if (get_ptr_to_agent_infront_of_agent(game, agent) != NULL)
-		return ENV_AGENT;
+	for (size_t i = 0; i < WALLS_COUNT; ++i)
+		index->wall[game->walls[i].pos.y][game->walls[i].pos.x] = true;
 
-	if (get_ptr_to_wall_infront_of_agent(game, agent) != NULL)
-		return ENV_WALL;
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		if (game->agents[i].health > 0)
+			board_index_add_agent(index, game, i);
+	}
+}
 
-	return ENV_NOTHING;
+void board_index_add_agent(BoardIndex *index, const Game *game, size_t agent_index) {
+	Position pos = game->agents[agent_index].pos;
+
+	index->agents_count[pos.y][pos.x] += 1;
+	if (index->agents_count[pos.y][pos.x] == 1)
+		index->agent[pos.y][pos.x] = (int16_t)agent_index;
 }
 
-void execute_action(Game *game, Agent *agent, AgentAction action) {
-	agent->action_history[agent->lifetime] = agent_action_as_verbose_action(action);
+// Has to be called while the agent is still on its cell: before it moves away, or right after it died.
+void board_index_remove_agent(BoardIndex *index, const Game *game, size_t agent_index) {
+	Position pos = game->agents[agent_index].pos;
 
-	switch (action) {
-	case AA_NOTHING: break;
+	index->agents_count[pos.y][pos.x] -= 1;
+	index->agent[pos.y][pos.x] = BOARD_CELL_EMPTY;
 
-	case AA_STEP: {
-		Food *food = get_ptr_to_food_infront_of_agent(game, agent);
-		Agent *victim = get_ptr_to_agent_infront_of_agent(game, agent);
-		Wall *wall = get_ptr_to_wall_infront_of_agent(game, agent);
+	if (index->agents_count[pos.y][pos.x] != 1)
+		return;
 
-		if (food != NULL) {
-			agent->action_history[agent->lifetime] = VA_FOOD;
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		const Agent *other = &game->agents[i];
+		if (i != agent_index && other->health > 0 && positions_are_equal(other->pos, pos)) {
+			index->agent[pos.y][pos.x] = (int16_t)i;
+			return;
+		}
+	}
+}
 
-			// printf("\t\tAgent %zu ate the food!\n", agent->index);
-			food->quantity -= 1;
-			agent->hunger -= FOOD_HUNGER_RECOVERY;
+Food *board_index_food_at(const BoardIndex *index, Game *game, Position pos) {
+	int16_t cell = index->food[pos.y][pos.x];
 
-			if (agent->hunger < 0)
-				agent->hunger = 0;
+	if (cell == BOARD_CELL_EMPTY)
+		return NULL;
 
-			// in case of food quantity == 1 on initialization,
-			// I can experiment with occupying the tile after eating the food.
-			move_agent(agent);
-		} else if (victim != NULL) {
-			agent->action_history[agent->lifetime] = VA_ATTACK;
+	if (cell == BOARD_CELL_SHARED) {
+		for (size_t i = 0; i < FOOD_COUNT; ++i) {
+			if (game->food[i].quantity > 0 && positions_are_equal(game->food[i].pos, pos))
+				return &game->food[i];
+		}
+		return NULL;
+	}
 
-			// printf("\t\tAgent %zu performed an attack!\n", agent->index);
-			victim->health -= ATTACK_DMG;
-			victim->hunger += HUNGER_TICK;
-			if (victim->hunger > LETHAL_HUNGER)
-				victim->hunger = LETHAL_HUNGER;
+	Food *food = &game->food[cell];
+	return food->quantity > 0 ? food : NULL;
+}
 
-			agent->health -= RETALIATION_DMG;
-			agent->hunger -= HUNGER_TICK;
+Agent *board_index_agent_at(const BoardIndex *index, Game *game, Position pos) {
+	uint8_t count = index->agents_count[pos.y][pos.x];
 
-			// No check for negative hp here.
-			// We perform all actions first, then declare dead agents.
-		} else if (wall == NULL) {
-			// printf("\t\tAgent %zu just steped forward and that's it.\n", agent->index);
-			move_agent(agent);
-		}
-	} break;
+	if (count == 0)
+		return NULL;
 
-	case AA_TURN_LEFT:
-		// this is absolutely brilliant!
-		agent->direction = (Direction)mod_int((int)agent->direction + 1, 4);
-		break;
+	if (count == 1)
+		return &game->agents[index->agent[pos.y][pos.x]];
 
-	case AA_TURN_RIGHT: agent->direction = (Direction)mod_int((int)agent->direction - 1, 4); break;
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		if (game->agents[i].health > 0 && positions_are_equal(game->agents[i].pos, pos))
+			return &game->agents[i];
+	}
 
-	case AA_COUNT:
-	default: assert(0 && "This is not supposed to happen, fix the 'action' value."); break;
+	return NULL;
+}
+
+bool board_index_wall_at(const BoardIndex *index, Position pos) {
+	return index->wall[pos.y][pos.x];
+}
+
+// Food beats agents, agents beat walls.
+Environment sense_environment(const BoardIndex *index, Game *game, Position infront) {
+	if (board_index_food_at(index, game, infront) != NULL)
+		return ENV_FOOD;
+
+	if (board_index_agent_at(index, game, infront) != NULL)
+		return ENV_AGENT;
+
+	if (board_index_wall_at(index, infront))
+		return ENV_WALL;
+
+	return ENV_NOTHING;
+}
+
+// Any action but a turn turns by zero quarters.
+void turn_agent(Agent *agent, AgentAction action) {
+	agent->direction = (Direction)(((unsigned int)agent->direction + action_quarter_turns[action]) & 3u);
+}
+
+// Returns what actually happened, for VA_FOOD and VA_ATTACK `target_index` is the index of the food/victim.
+VerboseAction execute_action(Game *game, BoardIndex *index, Agent *agent, AgentAction action, size_t *target_index) {
+	VerboseAction outcome = agent_action_as_verbose_action(action);
+	size_t agent_index = (size_t)(agent - game->agents);
+
+	if (action == AA_STEP) {
+		Position infront = get_position_infront_of_agent(agent);
+		Food *food = board_index_food_at(index, game, infront);
+		Agent *victim = food == NULL ? board_index_agent_at(index, game, infront) : NULL;
+
+		if (food != NULL) {
+			outcome = VA_FOOD;
+			*target_index = (size_t)(food - game->food);
+
+			board_index_remove_agent(index, game, agent_index);
+			feed_agent(agent, food);
+			board_index_add_agent(index, game, agent_index);
+		} else if (victim != NULL) {
+			outcome = VA_ATTACK;
+			*target_index = (size_t)(victim - game->agents);
+
+			// Damage is dealt one attack at a time, whoever drops to zero is off the board right away.
+			attack_agent(agent, victim);
+			if (victim->health <= 0)
+				board_index_remove_agent(index, game, *target_index);
+			if (agent->health <= 0)
+				board_index_remove_agent(index, game, agent_index);
+		} else if (!board_index_wall_at(index, infront)) {
+			board_index_remove_agent(index, game, agent_index);
+			move_agent(agent);
+			board_index_add_agent(index, game, agent_index);
+		}
+	} else {
+		turn_agent(agent, action);
 	}
+
+#if GAME_RECORD_HISTORY
+	agent->action_history[agent->lifetime] = outcome;
+#endif
+	return outcome;
 }
 
 // qm_todo: different mating strategies? second chances?
-void mate_agents(const Agent *parent_a, const Agent *parent_b, Agent *child) {
+void mate_chromosomes(const Chromosome *parent_a, const Chromosome *parent_b, Chromosome *child) {
 	const size_t OFFSET = GENES_COUNT / 2;
 	const size_t GENE_SIZE = sizeof(Gene);
 
-	memcpy(child->chromosome.genes, parent_a->chromosome.genes, OFFSET * GENE_SIZE);
-	memcpy(child->chromosome.genes + OFFSET, parent_b->chromosome.genes + OFFSET, OFFSET * GENE_SIZE);
+	memcpy(child->genes, parent_a->genes, OFFSET * GENE_SIZE);
+	memcpy(child->genes + OFFSET, parent_b->genes + OFFSET, OFFSET * GENE_SIZE);
 }
 
-void mutate_agent(Agent *agent) {
+void mutate_chromosome(Chromosome *chromosome) {
 	// very crude mutation algorithm, but it works
 	// qm_todo: improve it later.
 	for (size_t i = 0; i < GENES_COUNT; ++i) {
 		if (random_int_range(0, MUTATION_PROBABILITY) < MUTATION_THRESHHOLD) {
-			initialize_gene(&agent->chromosome.genes[i]);
+			initialize_gene(&chromosome->genes[i]);
 		}
 	}
 }
 
-int agent_lifetime_comparator(const void *a, const void *b) {
-	return (int)(((const Agent *)b)->lifetime - ((const Agent *)a)->lifetime);
+int agent_rank_comparator(const void *a, const void *b) {
+	const AgentRank *rank_a = a;
+	const AgentRank *rank_b = b;
+
+	if (rank_a->lifetime != rank_b->lifetime)
+		return rank_a->lifetime < rank_b->lifetime ? 1 : -1;
+
+	// Agents still alive in a game that was stopped early (see play_game) will outlive the ones that
+	// died with the same lifetime, so they rank above them. Survival is read off the death cause, it's
+	// what every way of evaluating a game agrees on.
+	return (int)rank_b->alive - (int)rank_a->alive;
 }
 
 // This function is genious!
 //
-// It sorts agents in descending order based on their lifetime.
+// It ranks agents in descending order based on their lifetime.
 //
-// Best of them (in index range [0; MATING_SELECTION_POOL)) will be used to create
+// Best of them (in rank range [0; MATING_SELECTION_POOL)) will be used to create
 // chromosomes for the next game.
 //
 // On top of having the two halfs of the best genotypes, a new agent has a chance to undergo a
 // mutation which can change some of his genes (for better of worse).
 //
 // Everything else is just a basic setup of game properties.
+//
+// Parents are referenced by index, nothing in the previous game moves, and children are written
+// straight into the genomes of the next one: a single pass over two contiguous blocks.
 void prepare_next_game(Game *previous_game, Game *next_game) {
-	memset(next_game, 0, sizeof(*next_game));
-
-	qsort(previous_game->agents, AGENTS_COUNT, sizeof(Agent), agent_lifetime_comparator);
+	// qsort only ever compares what the reference comparator does, so ties end up in the order
+	// the reference engine sorts agents in.
+	AgentRank ranks[AGENTS_COUNT];
+	for (size_t i = 0; i < AGENTS_COUNT; ++i)
+		ranks[i] = (AgentRank){ previous_game->agents[i].lifetime, previous_game->agents[i].death_cause == DC_ALIVE, i };
+	qsort(ranks, AGENTS_COUNT, sizeof(ranks[0]), agent_rank_comparator);
 
 	// qm_todo: should I regenerate it or copy from previous game?
 	// initialize_food(next_game);
@@ -519,15 +863,19 @@ void prepare_next_game(Game *previous_game, Game *next_game) {
 		next_game->food[i].quantity = 1;
 	}
 
-	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
-		size_t parent_a_index = (size_t)random_int_range(0, MATING_SELECTION_POOL);
-		size_t parent_b_index = (size_t)random_int_range(0, MATING_SELECTION_POOL);
+	// Nothing is cleared, every field that matters is set below. Agents that aren't placed yet
+	// block the corner cell for the ones being placed, like the zeroed agents of the reference do.
+	for (size_t i = 0; i < AGENTS_COUNT; ++i)
+		next_game->agents[i].pos = (Position){ 0, 0 };
 
-		mate_agents(&previous_game->agents[parent_a_index],
-			    &previous_game->agents[parent_b_index],
-			    &next_game->agents[i]);
+	const Chromosome *parents = previous_game->genomes;
+	Chromosome *children = next_game->genomes;
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		size_t parent_a_index = ranks[random_int_range(0, MATING_SELECTION_POOL)].index;
+		size_t parent_b_index = ranks[random_int_range(0, MATING_SELECTION_POOL)].index;
 
-		mutate_agent(&next_game->agents[i]);
+		mate_chromosomes(&parents[parent_a_index], &parents[parent_b_index], &children[i]);
+		mutate_chromosome(&children[i]);
 		initialize_basic_agent_properties(next_game, &next_game->agents[i], i);
 	}
 }
@@ -540,6 +888,13 @@ void dump_game_state(const char *filepath, const Game *game) {
 		return;
 	}
 
+	GameStateHeader header = {
+		.version = GAME_STATE_VERSION,
+		.record_history = GAME_RECORD_HISTORY,
+		.game_size = sizeof(*game),
+	};
+	memcpy(header.magic, GAME_STATE_MAGIC, sizeof(header.magic));
+	fwrite(&header, sizeof(header), 1, state_dump_file_handle);
 	fwrite(game, sizeof(*game), 1, state_dump_file_handle);
 	if (ferror(state_dump_file_handle)) {
 		fprintf(stderr, "ERROR: Couldn't write the file to dump the game's state.\n");
@@ -550,22 +905,48 @@ void dump_game_state(const char *filepath, const Game *game) {
 	fclose(state_dump_file_handle);
 }
 
-void load_game_state(const char *filepath, Game *game) {
+// The game is read aside first, `game` only changes once the whole file turned out to be right.
+bool load_game_state(const char *filepath, Game *game) {
 	FILE *state_dump_file_handle = fopen(filepath, "rb");
 
 	if (state_dump_file_handle == NULL) {
-		fprintf(stderr, "ERROR: Couldn't open the file to dump the game's state.\n");
-		return;
+		fprintf(stderr, "ERROR: Couldn't open %s to load the game's state.\n", filepath);
+		return false;
 	}
 
-	size_t read_chunks_count = fread(game, sizeof(*game), 1, state_dump_file_handle);
-	if (ferror(state_dump_file_handle) || read_chunks_count != 1) {
-		fprintf(stderr, "ERROR: Couldn't write the file to dump the game's state.\n");
+	GameStateHeader header;
+	Game *loaded = malloc(sizeof(*loaded));
+	bool result = false;
+
+	if (loaded == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate the game to load.\n");
+	} else if (fread(&header, sizeof(header), 1, state_dump_file_handle) != 1 ||
+		   memcmp(header.magic, GAME_STATE_MAGIC, sizeof(header.magic)) != 0) {
+		fprintf(stderr, "ERROR: %s isn't a saved game.\n", filepath);
+	} else if (header.version != GAME_STATE_VERSION || header.record_history != GAME_RECORD_HISTORY ||
+		   header.game_size != sizeof(*loaded)) {
+		fprintf(stderr,
+			"ERROR: %s was saved by another build (version %u, %s history, %llu bytes), "
+			"this one reads version %u, %s history, %zu bytes.\n",
+			filepath,
+			header.version,
+			header.record_history ? "with" : "without",
+			(unsigned long long)header.game_size,
+			GAME_STATE_VERSION,
+			GAME_RECORD_HISTORY ? "with" : "without",
+			sizeof(*loaded));
+	} else if (fread(loaded, sizeof(*loaded), 1, state_dump_file_handle) != 1 ||
+		   fgetc(state_dump_file_handle) != EOF) {
+		fprintf(stderr, "ERROR: %s is cut short or too long, it can't be the game it claims to be.\n", filepath);
 	} else {
+		memcpy(game, loaded, sizeof(*game));
 		fprintf(stdout, "INFO: Game state was successfully read from a file.\n");
+		result = true;
 	}
 
+	free(loaded);
 	fclose(state_dump_file_handle);
+	return result;
 }
 
 bool is_everyone_dead(const Game *game) {
@@ -575,3 +956,20 @@ bool is_everyone_dead(const Game *game) {
 	}
 	return true;
 }
+
+size_t count_alive_agents(const Game *game) {
+	size_t result = 0;
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i)
+		result += game->agents[i].health > 0;
+
+	return result;
+}
+
+void play_game(Game *game, size_t survivors) {
+	DecisionTable table;
+	const DecisionTable *decisions = decision_table_build(&table, game);
+
+	while (count_alive_agents(game) > survivors)
+		game_step_with_table(game, decisions);
+}
@@ -2,6 +2,7 @@
 #define GAME_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
 
@@ -28,6 +29,16 @@
 #define MUTATION_THRESHHOLD 16
 #define MATING_SELECTION_POOL 16
 
+#define GAME_STATE_FILEPATH "./output/game_state.bin"
+#define GAME_STATE_MAGIC "GPGS"
+#define GAME_STATE_VERSION 2
+
+// Per-agent action/gene history arrays cost 4 KB per agent, long runs can
+// record an event log instead (see event_log.h) and build without them.
+#ifndef GAME_RECORD_HISTORY
+#define GAME_RECORD_HISTORY 1
+#endif
+
 typedef enum {
 	DIR_RIGHT = 0,
 	DIR_UP,
@@ -35,7 +46,7 @@ typedef enum {
 	DIR_DOWN,
 } Direction;
 
-typedef int AgentState;
+typedef uint8_t AgentState;
 
 typedef enum {
 	ENV_NOTHING = 0,
@@ -63,34 +74,51 @@ typedef enum {
 	VA_COUNT,
 } VerboseAction;
 
+typedef enum {
+	DC_ALIVE = 0,
+	DC_HUNGER,
+	DC_COMBAT,
+	DC_OLD_AGE,
+	DC_COUNT,
+} DeathCause;
+
+// The enums are stored in a byte each, a gene is a single 32-bit word.
 typedef struct {
 	AgentState current_state;
 	AgentState next_state;
-	Environment environment;
-	AgentAction action;
+	uint8_t environment; // Environment
+	uint8_t action; // AgentAction
 } Gene;
 
+// Aligned to a cache line, so that breeding streams whole lines in and out.
 typedef struct {
-	size_t count;
-	Gene genes[GENES_COUNT];
+	_Alignas(64) Gene genes[GENES_COUNT];
 } Chromosome;
 
 typedef struct {
-	int x;
-	int y;
+	int16_t x;
+	int16_t y;
 } Position;
 
+// Fields a tick touches are as narrow as their ranges allow, all but the gene counters and the history
+// are in the first 32 bytes.
 typedef struct {
 	size_t index;
 	Position pos;
-	Direction direction;
+	uint8_t direction; // Direction
 	AgentState current_state;
-	int hunger;
-	int health;
+	int16_t hunger;
+	int16_t health;
+	uint8_t death_cause; // DeathCause
 	size_t lifetime;
+	size_t food_eaten;
+	size_t attacks_dealt;
+	size_t attacks_received;
+	uint16_t gene_usage[GENES_COUNT]; // how many times every gene fired, cheap even without the history
+#if GAME_RECORD_HISTORY
 	VerboseAction action_history[MAX_LIFETIME];
 	int used_genes_history[MAX_LIFETIME];
-	Chromosome chromosome;
+#endif
 } Agent;
 
 typedef struct {
@@ -104,19 +132,49 @@ typedef struct {
 
 typedef struct {
 	Agent agents[AGENTS_COUNT];
+	// The genome of agents[i] is genomes[i]. A generation's genomes are one contiguous block,
+	// the next one is bred from it in a single pass (see prepare_next_game).
+	Chromosome genomes[AGENTS_COUNT];
 	Food food[FOOD_COUNT];
 	Wall walls[WALLS_COUNT];
 } Game;
 
+// Everything that decides the layout of a saved Game, see load_game_state.
+typedef struct {
+	char magic[4];
+	uint32_t version;
+	uint32_t record_history; // GAME_RECORD_HISTORY of the build that saved it
+	uint32_t padding;
+	uint64_t game_size;
+} GameStateHeader;
+
+typedef struct EventLog EventLog;
+
+// For every agent, state and environment, the index of the first gene that fires, GENES_COUNT when none does.
+// Chromosomes don't change while a game is played, so a whole game can be played off one of these.
+typedef struct {
+	uint8_t first_gene[AGENTS_COUNT][STATES_COUNT][ENV_COUNT];
+} DecisionTable;
+
 int mod_int(int first, int second);
+void seed_random(unsigned int seed);
 
 void print_gene(FILE *stream, const Gene *gene, size_t agent_index, size_t gene_index);
 void print_chromosome(FILE *stream, const Chromosome *chromosome, size_t agent_index);
 void print_agent(FILE *stream, const Agent *a);
-void print_agent_verbose(FILE *stream, const Agent *a);
+void print_agent_verbose(FILE *stream, const Agent *a, const Chromosome *chromosome);
 void print_the_state_of_oldest_agent(Game *game);
+const char *death_cause_as_cstr(DeathCause dc);
 
 Position get_position_infront_of_agent(const Agent *agent);
+void move_agent(Agent *agent);
+void turn_agent(Agent *agent, AgentAction action);
+
+// The rules live here so that everything replaying the game (see event_log.c) applies them exactly like game_step.
+bool age_agent(Agent *agent);
+void feed_agent(Agent *agent, Food *food);
+void attack_agent(Agent *attacker, Agent *victim);
+void starve_agent(Agent *agent);
 
 Food *get_ptr_to_food_infront_of_agent(Game *game, Agent *agent);
 Agent *get_ptr_to_agent_infront_of_agent(Game *game, Agent *agent);
@@ -127,11 +185,35 @@ Food *get_ptr_to_food_at_pos(Game *game, Position pos);
 Wall *get_ptr_to_wall_at_pos(Game *game, Position pos);
 
 void initialize_game(Game *game);
+void initialize_basic_agent_properties(Game *game, Agent *agent, size_t agent_index);
+void initialize_gene(Gene *gene);
+int random_int_range(int low, int high);
+Position random_empty_position(const Game *game);
+
+void mate_chromosomes(const Chromosome *parent_a, const Chromosome *parent_b, Chromosome *child);
+void mutate_chromosome(Chromosome *chromosome);
+
 void game_step(Game *game);
+void game_step_logged(Game *game, EventLog *log);
+// The same tick, with `table` built from this game's chromosomes (or NULL, which scans the genes).
+void game_step_with_table(Game *game, const DecisionTable *table);
+// Returns `table`, or NULL when some gene or state is out of range and the genes have to be scanned.
+const DecisionTable *decision_table_build(DecisionTable *table, const Game *game);
 void prepare_next_game(Game *previous_game, Game *next_game);
 
+// The unoptimized engine from game_reference.c, the definition of what game_step and prepare_next_game have to do.
+void game_step_reference(Game *game);
+void prepare_next_game_reference(Game *previous_game, Game *next_game);
+
+// A saved game is a GameStateHeader followed by the Game as it is in memory. Only a build with the same
+// layout of Game can load it: on anything else load_game_state returns false and leaves `game` alone.
 void dump_game_state(const char *filepath, const Game *game);
-void load_game_state(const char *filepath, Game *game);
+bool load_game_state(const char *filepath, Game *game);
 bool is_everyone_dead(const Game *game);
+size_t count_alive_agents(const Game *game);
+
+// Steps the game until no more than `survivors` agents are alive, 0 plays it to extinction.
+// Survivors keep DC_ALIVE and the lifetime they had so far.
+void play_game(Game *game, size_t survivors);
 
 #endif // GAME_H
@@ -0,0 +1,270 @@
+#include "game.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The engine the way it was before anybody optimized it, kept as the definition of the rules.
+//
+// It's slow on purpose: every lookup scans the whole board and nothing is cached. Don't make
+// it faster and don't share code with game.c beyond the random generator and the setup of new
+// agents, `trainer --verify` (see verify.c) runs it next to game_step and expects every tick to end
+// in exactly the same state.
+
+Position reference_directions[4] = {
+	{ 1, 0 }, // DIR_RIGHT
+	{ 0, -1 }, // DIR_UP
+	{ -1, 0 }, // DIR_LEFT
+	{ 0, 1 }, // DIR_DOWN
+};
+
+int reference_mod_int(int first, int second);
+bool reference_positions_are_equal(Position first, Position second);
+Position reference_position_infront_of_agent(const Agent *agent);
+void reference_move_agent(Agent *agent);
+
+Food *reference_food_infront_of_agent(Game *game, Agent *agent);
+Agent *reference_agent_infront_of_agent(Game *game, Agent *agent);
+Wall *reference_wall_infront_of_agent(Game *game, Agent *agent);
+Environment reference_interpret_environment(Game *game, Agent *agent);
+VerboseAction reference_execute_action(Game *game, Agent *agent, AgentAction action);
+
+void reference_mate_chromosomes(const Chromosome *parent_a, const Chromosome *parent_b, Chromosome *child);
+void reference_mutate_chromosome(Chromosome *chromosome);
+int reference_lifetime_comparator(const void *a, const void *b);
+
+void game_step_reference(Game *game) {
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		Agent *agent = &game->agents[i];
+
+		if (agent->health <= 0)
+			continue;
+
+		agent->lifetime += 1;
+		if (agent->lifetime == MAX_LIFETIME) {
+			agent->health = 0;
+			agent->death_cause = DC_OLD_AGE;
+			continue;
+		}
+
+		for (size_t j = 0; j < GENES_COUNT; ++j) {
+			Gene *gene = &game->genomes[i].genes[j];
+
+			if (gene->current_state != agent->current_state)
+				continue;
+
+			if (gene->environment != reference_interpret_environment(game, agent))
+				continue;
+
+			reference_execute_action(game, agent, gene->action);
+			agent->gene_usage[j] += 1;
+#if GAME_RECORD_HISTORY
+			agent->used_genes_history[agent->lifetime] = (int)j;
+#endif
+			agent->current_state = gene->next_state;
+			break;
+		}
+	}
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		Agent *agent = &game->agents[i];
+
+		if (agent->health <= 0)
+			continue;
+
+		if (agent->hunger >= LETHAL_HUNGER) {
+			agent->hunger = LETHAL_HUNGER;
+			agent->health -= HUNGER_TICK;
+			if (agent->health <= 0)
+				agent->death_cause = DC_HUNGER;
+			continue;
+		}
+
+		agent->hunger += HUNGER_TICK;
+	}
+}
+
+void prepare_next_game_reference(Game *previous_game, Game *next_game) {
+	memset(next_game, 0, sizeof(*next_game));
+
+	qsort(previous_game->agents, AGENTS_COUNT, sizeof(Agent), reference_lifetime_comparator);
+
+	memcpy(next_game->walls, previous_game->walls, WALLS_COUNT * sizeof(Wall));
+	memcpy(next_game->food, previous_game->food, FOOD_COUNT * sizeof(Food));
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		next_game->food[i].quantity = 1;
+	}
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		size_t parent_a_index = (size_t)random_int_range(0, MATING_SELECTION_POOL);
+		size_t parent_b_index = (size_t)random_int_range(0, MATING_SELECTION_POOL);
+
+		// Sorting moved the agents but not their genomes, `index` is still the slot the genome is in.
+		reference_mate_chromosomes(&previous_game->genomes[previous_game->agents[parent_a_index].index],
+					   &previous_game->genomes[previous_game->agents[parent_b_index].index],
+					   &next_game->genomes[i]);
+
+		reference_mutate_chromosome(&next_game->genomes[i]);
+		initialize_basic_agent_properties(next_game, &next_game->agents[i], i);
+	}
+}
+
+int reference_mod_int(int first, int second) {
+	return (first % second + second) % second;
+}
+
+bool reference_positions_are_equal(Position first, Position second) {
+	return first.x == second.x && first.y == second.y;
+}
+
+Position reference_position_infront_of_agent(const Agent *agent) {
+	Position delta = reference_directions[agent->direction];
+	Position next = agent->pos;
+
+	next.x = (int16_t)reference_mod_int(next.x + delta.x, BOARD_WIDTH);
+	next.y = (int16_t)reference_mod_int(next.y + delta.y, BOARD_HEIGHT);
+
+	return next;
+}
+
+void reference_move_agent(Agent *agent) {
+	agent->pos = reference_position_infront_of_agent(agent);
+}
+
+Food *reference_food_infront_of_agent(Game *game, Agent *agent) {
+	Position infront = reference_position_infront_of_agent(agent);
+
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		if (game->food[i].quantity > 0 && reference_positions_are_equal(game->food[i].pos, infront))
+			return &game->food[i];
+	}
+
+	return NULL;
+}
+
+Agent *reference_agent_infront_of_agent(Game *game, Agent *agent) {
+	Position infront = reference_position_infront_of_agent(agent);
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		if (reference_positions_are_equal(game->agents[i].pos, infront) && game->agents[i].health > 0)
+			return &game->agents[i];
+	}
+
+	return NULL;
+}
+
+Wall *reference_wall_infront_of_agent(Game *game, Agent *agent) {
+	Position infront = reference_position_infront_of_agent(agent);
+
+	for (size_t i = 0; i < WALLS_COUNT; ++i) {
+		if (reference_positions_are_equal(game->walls[i].pos, infront))
+			return &game->walls[i];
+	}
+
+	return NULL;
+}
+
+// Food beats agents, agents beat walls.
+Environment reference_interpret_environment(Game *game, Agent *agent) {
+	if (reference_food_infront_of_agent(game, agent) != NULL)
+		return ENV_FOOD;
+
+	if (reference_agent_infront_of_agent(game, agent) != NULL)
+		return ENV_AGENT;
+
+	if (reference_wall_infront_of_agent(game, agent) != NULL)
+		return ENV_WALL;
+
+	return ENV_NOTHING;
+}
+
+VerboseAction reference_execute_action(Game *game, Agent *agent, AgentAction action) {
+	VerboseAction outcome = VA_NOTHING;
+
+	switch (action) {
+	case AA_NOTHING: break;
+
+	case AA_STEP: {
+		Food *food = reference_food_infront_of_agent(game, agent);
+		Agent *victim = reference_agent_infront_of_agent(game, agent);
+		Wall *wall = reference_wall_infront_of_agent(game, agent);
+
+		outcome = VA_STEP;
+		if (food != NULL) {
+			outcome = VA_FOOD;
+			food->quantity -= 1;
+			agent->hunger -= FOOD_HUNGER_RECOVERY;
+			agent->food_eaten += 1;
+			if (agent->hunger < 0)
+				agent->hunger = 0;
+			reference_move_agent(agent);
+		} else if (victim != NULL) {
+			outcome = VA_ATTACK;
+			victim->health -= ATTACK_DMG;
+			victim->hunger += HUNGER_TICK;
+			if (victim->hunger > LETHAL_HUNGER)
+				victim->hunger = LETHAL_HUNGER;
+
+			agent->health -= RETALIATION_DMG;
+			agent->hunger -= HUNGER_TICK;
+
+			agent->attacks_dealt += 1;
+			victim->attacks_received += 1;
+
+			if (victim->health <= 0)
+				victim->death_cause = DC_COMBAT;
+			if (agent->health <= 0)
+				agent->death_cause = DC_COMBAT;
+		} else if (wall == NULL) {
+			reference_move_agent(agent);
+		}
+	} break;
+
+	case AA_TURN_LEFT:
+		agent->direction = (Direction)reference_mod_int((int)agent->direction + 1, 4);
+		outcome = VA_TURN_LEFT;
+		break;
+
+	case AA_TURN_RIGHT:
+		agent->direction = (Direction)reference_mod_int((int)agent->direction - 1, 4);
+		outcome = VA_TURN_RIGHT;
+		break;
+
+	case AA_COUNT:
+	default: assert(0 && "This is not supposed to happen, fix the 'action' value."); break;
+	}
+
+#if GAME_RECORD_HISTORY
+	agent->action_history[agent->lifetime] = outcome;
+#else
+	(void)outcome;
+#endif
+	return outcome;
+}
+
+void reference_mate_chromosomes(const Chromosome *parent_a, const Chromosome *parent_b, Chromosome *child) {
+	const size_t OFFSET = GENES_COUNT / 2;
+	const size_t GENE_SIZE = sizeof(Gene);
+
+	memcpy(child->genes, parent_a->genes, OFFSET * GENE_SIZE);
+	memcpy(child->genes + OFFSET, parent_b->genes + OFFSET, OFFSET * GENE_SIZE);
+}
+
+void reference_mutate_chromosome(Chromosome *chromosome) {
+	for (size_t i = 0; i < GENES_COUNT; ++i) {
+		if (random_int_range(0, MUTATION_PROBABILITY) < MUTATION_THRESHHOLD) {
+			initialize_gene(&chromosome->genes[i]);
+		}
+	}
+}
+
+int reference_lifetime_comparator(const void *a, const void *b) {
+	const Agent *agent_a = a;
+	const Agent *agent_b = b;
+
+	if (agent_a->lifetime != agent_b->lifetime)
+		return agent_a->lifetime < agent_b->lifetime ? 1 : -1;
+
+	// Survivors of a game that was stopped early first.
+	return (int)(agent_b->death_cause == DC_ALIVE) - (int)(agent_a->death_cause == DC_ALIVE);
+}
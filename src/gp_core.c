@@ -0,0 +1,130 @@
+#include "gp_core.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool gp_world_is_valid(const GpWorld *world);
+bool gp_genome_is_valid(const GpGenome *genome);
+void gp_setup_game(const GpWorld *world, const GpGenome *genomes, size_t genomes_count, Game *game);
+
+void gp_world_generate(GpWorld *world, uint32_t seed) {
+	Game *game = calloc(1, sizeof(*game));
+	if (game == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate the game to generate a world.\n");
+		memset(world, 0, sizeof(*world));
+		return;
+	}
+
+	seed_random(seed);
+	initialize_game(game);
+	gp_world_from_game(world, game, seed);
+	free(game);
+}
+
+void gp_world_from_game(GpWorld *world, const Game *game, uint32_t seed) {
+	memset(world, 0, sizeof(*world));
+	world->seed = seed;
+
+	for (size_t i = 0; i < WALLS_COUNT; ++i)
+		world->walls[i] = (PackedPosition){ (uint8_t)game->walls[i].pos.x, (uint8_t)game->walls[i].pos.y };
+	for (size_t i = 0; i < FOOD_COUNT; ++i)
+		world->food[i] = (PackedPosition){ (uint8_t)game->food[i].pos.x, (uint8_t)game->food[i].pos.y };
+}
+
+void gp_genome_from_chromosome(GpGenome *genome, const Chromosome *chromosome) {
+	for (size_t i = 0; i < GENES_COUNT; ++i)
+		genome->genes[i] = pack_gene(&chromosome->genes[i]);
+}
+
+bool gp_evaluate_batch(const GpWorld *world, const GpGenome *genomes, size_t genomes_count, GpFitness *fitness) {
+	if (!gp_world_is_valid(world)) {
+		fprintf(stderr, "ERROR: The world has walls or food outside of the board.\n");
+		return false;
+	}
+
+	for (size_t i = 0; i < genomes_count; ++i) {
+		if (!gp_genome_is_valid(&genomes[i])) {
+			fprintf(stderr, "ERROR: Genome %zu has states outside of [0; %d).\n", i, STATES_COUNT);
+			return false;
+		}
+	}
+
+	Game *game = malloc(sizeof(*game));
+	if (game == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate the game to evaluate genomes in.\n");
+		return false;
+	}
+
+	for (size_t first = 0; first < genomes_count; first += AGENTS_COUNT) {
+		size_t count = genomes_count - first < AGENTS_COUNT ? genomes_count - first : AGENTS_COUNT;
+
+		// Games don't depend on each other, a genome gets the same fitness in any batch that starts the same.
+		seed_random(world->seed + (uint32_t)(first / AGENTS_COUNT));
+		gp_setup_game(world, &genomes[first], count, game);
+		play_game(game, world->survivors);
+
+		for (size_t i = 0; i < count; ++i) {
+			const Agent *agent = &game->agents[i];
+			fitness[first + i] = (GpFitness){
+				.lifetime = (uint16_t)agent->lifetime,
+				.food_eaten = (uint16_t)agent->food_eaten,
+				.attacks_dealt = (uint16_t)agent->attacks_dealt,
+				.attacks_received = (uint16_t)agent->attacks_received,
+				.death_cause = (uint8_t)agent->death_cause,
+			};
+		}
+	}
+
+	free(game);
+	return true;
+}
+
+bool gp_world_is_valid(const GpWorld *world) {
+	for (size_t i = 0; i < WALLS_COUNT; ++i) {
+		if (world->walls[i].x >= BOARD_WIDTH || world->walls[i].y >= BOARD_HEIGHT)
+			return false;
+	}
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		if (world->food[i].x >= BOARD_WIDTH || world->food[i].y >= BOARD_HEIGHT)
+			return false;
+	}
+
+	return true;
+}
+
+// Packed genes have room for more states than agents have.
+bool gp_genome_is_valid(const GpGenome *genome) {
+	for (size_t i = 0; i < GENES_COUNT; ++i) {
+		Gene gene = unpack_gene(genome->genes[i]);
+		if (gene.current_state >= STATES_COUNT || gene.next_state >= STATES_COUNT)
+			return false;
+	}
+
+	return true;
+}
+
+// Walls and food first, so that agents are placed around them like in a new game.
+void gp_setup_game(const GpWorld *world, const GpGenome *genomes, size_t genomes_count, Game *game) {
+	memset(game, 0, sizeof(*game));
+
+	for (size_t i = 0; i < WALLS_COUNT; ++i)
+		game->walls[i].pos = (Position){ world->walls[i].x, world->walls[i].y };
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		game->food[i].pos = (Position){ world->food[i].x, world->food[i].y };
+		game->food[i].quantity = 1;
+	}
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		Agent *agent = &game->agents[i];
+
+		if (i < genomes_count) {
+			for (size_t j = 0; j < GENES_COUNT; ++j)
+				game->genomes[i].genes[j] = unpack_gene(genomes[i].genes[j]);
+		}
+
+		initialize_basic_agent_properties(game, agent, i);
+		if (i >= genomes_count)
+			agent->health = 0;
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef GP_CORE_H
+#define GP_CORE_H
+
+#include "game.h"
+#include "packed_game.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Entry point for programs that embed the engine: gp_core is game.c and friends plus the software
+ * rasterizer from raster.h, without SDL, it only needs the C and math libraries. The rest of game.h
+ * stays available to them.
+ *
+ * Genomes are evaluated in games of AGENTS_COUNT agents, so they are judged by how they cope
+ * with each other, just like in the trainer. The same world, genomes and order always give the
+ * same fitness.
+ */
+
+#define GP_CORE_API_VERSION 1
+
+// Where the walls and the food are. Every game of a batch starts from the same layout.
+typedef struct {
+	uint32_t seed;
+	uint32_t survivors; // a game stops once no more agents than this are alive, see play_game
+	PackedPosition walls[WALLS_COUNT];
+	PackedPosition food[FOOD_COUNT];
+} GpWorld;
+
+typedef struct {
+	PackedGene genes[GENES_COUNT];
+} GpGenome;
+
+typedef struct {
+	uint16_t lifetime;
+	uint16_t food_eaten;
+	uint16_t attacks_dealt;
+	uint16_t attacks_received;
+	uint8_t death_cause;
+	uint8_t padding;
+} GpFitness;
+
+// A random layout, the same for the same seed.
+void gp_world_generate(GpWorld *world, uint32_t seed);
+void gp_world_from_game(GpWorld *world, const Game *game, uint32_t seed);
+
+void gp_genome_from_chromosome(GpGenome *genome, const Chromosome *chromosome);
+
+// Plays genomes[0..AGENTS_COUNT) in one game, the next AGENTS_COUNT in another and so on, the last game
+// is filled up with agents that are dead from the start. `fitness[i]` is what `genomes[i]` achieved.
+// Reseeds the random generator of the calling thread. Returns false when the world or a genome is invalid
+// or there is no memory for a game, `fitness` is incomplete then.
+bool gp_evaluate_batch(const GpWorld *world, const GpGenome *genomes, size_t genomes_count, GpFitness *fitness);
+
+#endif // !GP_CORE_H
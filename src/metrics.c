@@ -0,0 +1,274 @@
+#include "metrics.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METRICS_MAGIC "GPMT"
+#define METRICS_FIELD_SIZE (METRICS_FIELD_NAME_CAPACITY + 2 * sizeof(uint16_t) + sizeof(uint32_t))
+#define METRICS_FILEPATH_CAPACITY 512
+
+#define FIELD(record, member, type) { #member, type, 1, offsetof(record, member) }
+#define ARRAY_FIELD(record, member, type, count) { #member, type, count, offsetof(record, member) }
+#define FIELDS_COUNT(fields) (sizeof(fields) / sizeof((fields)[0]))
+
+static_assert(MAX_LIFETIME <= UINT16_MAX, "Agent metrics are stored in 16 bits.");
+static_assert(AGENTS_COUNT <= UINT16_MAX, "Agent index is stored in 16 bits.");
+static_assert(sizeof(MetricsAgentRecord) % sizeof(uint64_t) == 0, "Agent records keep their 64-bit fields aligned.");
+static_assert(sizeof(GenerationStats) % sizeof(uint64_t) == 0, "Generation records keep their 64-bit fields aligned.");
+
+const MetricsField generation_fields[] = {
+	FIELD(GenerationStats, generation, MF_U64),
+	FIELD(GenerationStats, islands_count, MF_U32),
+	FIELD(GenerationStats, agents_count, MF_U32),
+	FIELD(GenerationStats, best_lifetime, MF_U32),
+	FIELD(GenerationStats, p10_lifetime, MF_U32),
+	FIELD(GenerationStats, median_lifetime, MF_U32),
+	FIELD(GenerationStats, p90_lifetime, MF_U32),
+	FIELD(GenerationStats, mean_lifetime, MF_F32),
+	FIELD(GenerationStats, food_eaten, MF_U64),
+	FIELD(GenerationStats, attacks, MF_U64),
+	ARRAY_FIELD(GenerationStats, deaths, MF_U32, DC_COUNT),
+	ARRAY_FIELD(GenerationStats, alive_curve, MF_U32, STATS_ALIVE_CURVE_POINTS),
+	FIELD(GenerationStats, ticks, MF_U64),
+	FIELD(GenerationStats, ticks_per_second, MF_F32),
+	FIELD(GenerationStats, diversity, MF_F32),
+};
+
+const MetricsField agent_fields[] = {
+	FIELD(MetricsAgentRecord, generation, MF_U64),
+	FIELD(MetricsAgentRecord, island, MF_U16),
+	FIELD(MetricsAgentRecord, agent, MF_U16),
+	FIELD(MetricsAgentRecord, lifetime, MF_U16),
+	FIELD(MetricsAgentRecord, food_eaten, MF_U16),
+	FIELD(MetricsAgentRecord, attacks_dealt, MF_U16),
+	FIELD(MetricsAgentRecord, attacks_received, MF_U16),
+	FIELD(MetricsAgentRecord, death_cause, MF_U8),
+	ARRAY_FIELD(MetricsAgentRecord, gene_usage, MF_U16, GENES_COUNT),
+};
+
+bool metrics_open_table(BufferedWriter *writer,
+			BufferedWriter *csv_writer,
+			const char *prefix,
+			const char *table,
+			const MetricsField *fields,
+			size_t fields_count,
+			size_t record_size);
+void metrics_write_record(BufferedWriter *writer,
+			  BufferedWriter *csv_writer,
+			  const MetricsField *fields,
+			  size_t fields_count,
+			  const void *record,
+			  size_t record_size);
+void metrics_write_csv_value(BufferedWriter *writer, MetricsFieldType type, const uint8_t *at);
+size_t metrics_field_type_size(MetricsFieldType type);
+
+MetricsWriter *metrics_open(const char *prefix, bool csv) {
+	MetricsWriter *metrics = calloc(1, sizeof(*metrics));
+
+	if (metrics == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate the metrics writer.\n");
+		return NULL;
+	}
+
+	metrics->csv = csv;
+	bool opened = metrics_open_table(&metrics->generations,
+					 csv ? &metrics->generations_csv : NULL,
+					 prefix,
+					 "generations",
+					 generation_fields,
+					 FIELDS_COUNT(generation_fields),
+					 sizeof(GenerationStats)) &&
+		      metrics_open_table(&metrics->agents,
+					 csv ? &metrics->agents_csv : NULL,
+					 prefix,
+					 "agents",
+					 agent_fields,
+					 FIELDS_COUNT(agent_fields),
+					 sizeof(MetricsAgentRecord));
+
+	if (!opened) {
+		metrics_close(metrics);
+		return NULL;
+	}
+
+	return metrics;
+}
+
+bool metrics_close(MetricsWriter *metrics) {
+	if (metrics == NULL)
+		return false;
+
+	// Closing a writer that was never opened just reports a failure.
+	bool result = buffered_writer_close(&metrics->generations);
+	result = buffered_writer_close(&metrics->agents) && result;
+	if (metrics->csv) {
+		result = buffered_writer_close(&metrics->generations_csv) && result;
+		result = buffered_writer_close(&metrics->agents_csv) && result;
+	}
+
+	if (!result)
+		fprintf(stderr, "ERROR: Some of the metrics couldn't be written.\n");
+
+	free(metrics);
+	return result;
+}
+
+void metrics_write_generation(MetricsWriter *metrics, const GenerationStats *stats) {
+	metrics_write_record(&metrics->generations,
+			     metrics->csv ? &metrics->generations_csv : NULL,
+			     generation_fields,
+			     FIELDS_COUNT(generation_fields),
+			     stats,
+			     sizeof(*stats));
+}
+
+void metrics_write_agents(MetricsWriter *metrics, uint64_t generation, size_t island, const Game *game) {
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		const Agent *agent = &game->agents[i];
+		MetricsAgentRecord record = {
+			.generation = generation,
+			.island = (uint16_t)island,
+			.agent = (uint16_t)i,
+			.lifetime = (uint16_t)agent->lifetime,
+			.food_eaten = (uint16_t)agent->food_eaten,
+			.attacks_dealt = (uint16_t)agent->attacks_dealt,
+			.attacks_received = (uint16_t)agent->attacks_received,
+			.death_cause = (uint8_t)agent->death_cause,
+		};
+		memcpy(record.gene_usage, agent->gene_usage, sizeof(record.gene_usage));
+
+		metrics_write_record(&metrics->agents,
+				     metrics->csv ? &metrics->agents_csv : NULL,
+				     agent_fields,
+				     FIELDS_COUNT(agent_fields),
+				     &record,
+				     sizeof(record));
+	}
+}
+
+bool metrics_open_table(BufferedWriter *writer,
+			BufferedWriter *csv_writer,
+			const char *prefix,
+			const char *table,
+			const MetricsField *fields,
+			size_t fields_count,
+			size_t record_size) {
+	char filepath[METRICS_FILEPATH_CAPACITY];
+
+	snprintf(filepath, sizeof(filepath), "%s.%s.bin", prefix, table);
+	if (!buffered_writer_open(writer, filepath))
+		return false;
+
+	// Records start at an aligned offset, so that mapped columns can be read in place.
+	size_t header_size = 5 * sizeof(uint32_t) + fields_count * METRICS_FIELD_SIZE;
+	size_t padded_header_size = (header_size + METRICS_HEADER_ALIGNMENT - 1) / METRICS_HEADER_ALIGNMENT * METRICS_HEADER_ALIGNMENT;
+
+	buffered_writer_write(writer, METRICS_MAGIC, 4);
+	buffered_writer_write_u32(writer, METRICS_VERSION);
+	buffered_writer_write_u32(writer, (uint32_t)padded_header_size);
+	buffered_writer_write_u32(writer, (uint32_t)record_size);
+	buffered_writer_write_u32(writer, (uint32_t)fields_count);
+
+	for (size_t i = 0; i < fields_count; ++i) {
+		char name[METRICS_FIELD_NAME_CAPACITY] = { 0 };
+		snprintf(name, sizeof(name), "%s", fields[i].name);
+
+		buffered_writer_write(writer, name, sizeof(name));
+		buffered_writer_write_u16(writer, (uint16_t)fields[i].type);
+		buffered_writer_write_u16(writer, fields[i].count);
+		buffered_writer_write_u32(writer, fields[i].offset);
+	}
+
+	static const uint8_t zeros[METRICS_HEADER_ALIGNMENT] = { 0 };
+	buffered_writer_write(writer, zeros, padded_header_size - header_size);
+
+	if (csv_writer == NULL)
+		return true;
+
+	snprintf(filepath, sizeof(filepath), "%s.%s.csv", prefix, table);
+	if (!buffered_writer_open(csv_writer, filepath))
+		return false;
+
+	// Arrays are flattened into `name_0`, `name_1`, ... columns.
+	for (size_t i = 0; i < fields_count; ++i) {
+		for (uint16_t j = 0; j < fields[i].count; ++j) {
+			const char *separator = i + j == 0 ? "" : ",";
+			if (fields[i].count == 1)
+				buffered_writer_printf(csv_writer, "%s%s", separator, fields[i].name);
+			else
+				buffered_writer_printf(csv_writer, "%s%s_%u", separator, fields[i].name, (unsigned int)j);
+		}
+	}
+	buffered_writer_write(csv_writer, "\n", 1);
+
+	return true;
+}
+
+void metrics_write_record(BufferedWriter *writer,
+			  BufferedWriter *csv_writer,
+			  const MetricsField *fields,
+			  size_t fields_count,
+			  const void *record,
+			  size_t record_size) {
+	buffered_writer_write(writer, record, record_size);
+
+	if (csv_writer == NULL)
+		return;
+
+	const uint8_t *bytes = record;
+	for (size_t i = 0; i < fields_count; ++i) {
+		size_t element_size = metrics_field_type_size(fields[i].type);
+
+		for (uint16_t j = 0; j < fields[i].count; ++j) {
+			if (i + j > 0)
+				buffered_writer_write(csv_writer, ",", 1);
+			metrics_write_csv_value(csv_writer, fields[i].type, bytes + fields[i].offset + j * element_size);
+		}
+	}
+	buffered_writer_write(csv_writer, "\n", 1);
+}
+
+void metrics_write_csv_value(BufferedWriter *writer, MetricsFieldType type, const uint8_t *at) {
+	switch (type) {
+	case MF_U8: buffered_writer_printf(writer, "%u", (unsigned int)*at); break;
+
+	case MF_U16: {
+		uint16_t value;
+		memcpy(&value, at, sizeof(value));
+		buffered_writer_printf(writer, "%u", (unsigned int)value);
+	} break;
+
+	case MF_U32: {
+		uint32_t value;
+		memcpy(&value, at, sizeof(value));
+		buffered_writer_printf(writer, "%lu", (unsigned long)value);
+	} break;
+
+	case MF_U64: {
+		uint64_t value;
+		memcpy(&value, at, sizeof(value));
+		buffered_writer_printf(writer, "%llu", (unsigned long long)value);
+	} break;
+
+	case MF_F32: {
+		float value;
+		memcpy(&value, at, sizeof(value));
+		buffered_writer_printf(writer, "%g", (double)value);
+	} break;
+
+	default: assert(0 && "Unknown metrics field type."); break;
+	}
+}
+
+size_t metrics_field_type_size(MetricsFieldType type) {
+	switch (type) {
+	case MF_U8: return sizeof(uint8_t);
+	case MF_U16: return sizeof(uint16_t);
+	case MF_U32: return sizeof(uint32_t);
+	case MF_U64: return sizeof(uint64_t);
+	case MF_F32: return sizeof(float);
+	default: assert(0 && "Unknown metrics field type."); return 0;
+	}
+}
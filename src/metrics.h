@@ -0,0 +1,75 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "buffered_writer.h"
+#include "game.h"
+#include "stats.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define METRICS_VERSION 2
+#define METRICS_FIELD_NAME_CAPACITY 32
+#define METRICS_HEADER_ALIGNMENT 64
+
+/*
+ * Every table is a file of fixed-width records that can be mapped and indexed directly:
+ *
+ *    header       "GPMT", u32 version, u32 header size, u32 record size, u32 fields count
+ *    fields       name (32 bytes, zero padded), u16 type, u16 elements count, u32 offset inside the record
+ *    padding      zeros up to the header size, a multiple of METRICS_HEADER_ALIGNMENT
+ *    records      from the header size until the end of the file, there is no count to keep it appendable
+ *
+ * Records are laid out with every field aligned to its size, and sizes are multiples of 8, so once
+ * the file is mapped at a page boundary every value of every record is naturally aligned.
+ *
+ * A column is read by striding over the records: record size apart, starting at its offset.
+ * Values are in the host byte order. `<prefix>.generations.bin` has a record per generation,
+ * `<prefix>.agents.bin` a record per agent of every island in every generation.
+ */
+
+typedef enum {
+	MF_U8 = 0,
+	MF_U16,
+	MF_U32,
+	MF_U64,
+	MF_F32,
+} MetricsFieldType;
+
+typedef struct {
+	const char *name;
+	MetricsFieldType type;
+	uint16_t count;
+	uint32_t offset;
+} MetricsField;
+
+typedef struct {
+	uint64_t generation;
+	uint16_t island;
+	uint16_t agent;
+	uint16_t lifetime;
+	uint16_t food_eaten;
+	uint16_t attacks_dealt;
+	uint16_t attacks_received;
+	uint8_t death_cause;
+	uint8_t padding[3];
+	uint16_t gene_usage[GENES_COUNT];
+} MetricsAgentRecord;
+
+typedef struct {
+	bool csv;
+	BufferedWriter generations;
+	BufferedWriter agents;
+	BufferedWriter generations_csv;
+	BufferedWriter agents_csv;
+} MetricsWriter;
+
+// Returns NULL when any of the files couldn't be created. With `csv` every table gets a `.csv` twin.
+MetricsWriter *metrics_open(const char *prefix, bool csv);
+bool metrics_close(MetricsWriter *metrics);
+
+void metrics_write_generation(MetricsWriter *metrics, const GenerationStats *stats);
+void metrics_write_agents(MetricsWriter *metrics, uint64_t generation, size_t island, const Game *game);
+
+#endif // !METRICS_H
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "telemetry.h"
+
+#define MONITOR_POLL_INTERVAL_MS 250
+#define MONITOR_CURVE_WIDTH 32
+
+void sleep_ms(long milliseconds);
+void print_stats(const GenerationStats *stats);
+void print_alive_curve(const GenerationStats *stats);
+
+// Follows a running trainer through its telemetry segment, see telemetry.h.
+int main(int argc, char *argv[]) {
+	if (argc > 2) {
+		fprintf(stderr, "Usage: %s [%s]\n", argv[0], TELEMETRY_DEFAULT_NAME);
+		return 1;
+	}
+
+	const char *name = argc == 2 ? argv[1] : TELEMETRY_DEFAULT_NAME;
+
+	for (;;) {
+		Telemetry telemetry;
+
+		fprintf(stdout, "INFO: Waiting for a trainer publishing into `%s`.\n", name);
+		fflush(stdout);
+		while (!telemetry_attach(&telemetry, name))
+			sleep_ms(1000);
+
+		// Start from the latest generation, the history is in the trainer's own output.
+		uint64_t next = telemetry_published(&telemetry);
+		next = next > 0 ? next - 1 : 0;
+		fprintf(stdout, "INFO: Attached to the trainer with pid %d.\n", (int)telemetry.segment->writer_pid);
+
+		while (telemetry_writer_is_alive(&telemetry)) {
+			uint64_t published = telemetry_published(&telemetry);
+
+			if (published - next > TELEMETRY_CAPACITY) {
+				fprintf(stdout, "WARNING: Fell behind, %llu generations were skipped.\n",
+					(unsigned long long)(published - TELEMETRY_CAPACITY - next));
+				next = published - TELEMETRY_CAPACITY;
+			}
+
+			while (next < published) {
+				GenerationStats stats;
+				TelemetryReadResult result = telemetry_read(&telemetry, next, &stats);
+
+				if (result == TR_NOT_YET)
+					break;
+				if (result == TR_OK)
+					print_stats(&stats);
+				next += 1;
+			}
+
+			fflush(stdout);
+			sleep_ms(MONITOR_POLL_INTERVAL_MS);
+		}
+
+		fprintf(stdout, "INFO: The trainer is gone.\n");
+		telemetry_close(&telemetry);
+	}
+
+	return 0;
+}
+
+void sleep_ms(long milliseconds) {
+	struct timespec duration = { milliseconds / 1000, (milliseconds % 1000) * 1000000 };
+	nanosleep(&duration, NULL);
+}
+
+void print_stats(const GenerationStats *stats) {
+	fprintf(stdout,
+		"generation %6llu | lifetime best %3u mean %6.2f p10/50/90 %3u/%3u/%3u | food %6llu | attacks %6llu | "
+		"deaths hunger/combat/age %5u/%5u/%5u | diversity %4.2f | %8.0f ticks/s\n",
+		(unsigned long long)stats->generation,
+		stats->best_lifetime,
+		(double)stats->mean_lifetime,
+		stats->p10_lifetime,
+		stats->median_lifetime,
+		stats->p90_lifetime,
+		(unsigned long long)stats->food_eaten,
+		(unsigned long long)stats->attacks,
+		stats->deaths[DC_HUNGER],
+		stats->deaths[DC_COMBAT],
+		stats->deaths[DC_OLD_AGE],
+		(double)stats->diversity,
+		(double)stats->ticks_per_second);
+	print_alive_curve(stats);
+
+	if (stats->deaths[DC_ALIVE] > 0)
+		fprintf(stdout,
+			"           %u agents were alive when their games were ended, lifetimes are lower bounds\n",
+			stats->deaths[DC_ALIVE]);
+}
+
+// One character per couple of curve points, from '@' (everybody's alive) to ' ' (nobody is).
+void print_alive_curve(const GenerationStats *stats) {
+	const char RAMP[] = " .:-=+*#%@";
+	const size_t RAMP_LEVELS = sizeof(RAMP) - 2;
+	const size_t POINTS_PER_CHAR = STATS_ALIVE_CURVE_POINTS / MONITOR_CURVE_WIDTH;
+
+	char curve[MONITOR_CURVE_WIDTH + 1] = { 0 };
+	for (size_t i = 0; i < MONITOR_CURVE_WIDTH; ++i) {
+		uint32_t alive = stats->alive_curve[i * POINTS_PER_CHAR];
+		size_t level = stats->agents_count > 0 ? (size_t)alive * RAMP_LEVELS / stats->agents_count : 0;
+		curve[i] = RAMP[level];
+	}
+
+	fprintf(stdout, "           alive over %d ticks [%s]\n", MAX_LIFETIME, curve);
+}
@@ -0,0 +1,139 @@
+#include "packed_game.h"
+
+#include <assert.h>
+#include <string.h>
+
+#define GENE_STATE_BITS 4
+#define GENE_ENVIRONMENT_BITS 2
+#define GENE_ACTION_BITS 2
+
+#define GENE_CURRENT_STATE_SHIFT 0
+#define GENE_NEXT_STATE_SHIFT (GENE_CURRENT_STATE_SHIFT + GENE_STATE_BITS)
+#define GENE_ENVIRONMENT_SHIFT (GENE_NEXT_STATE_SHIFT + GENE_STATE_BITS)
+#define GENE_ACTION_SHIFT (GENE_ENVIRONMENT_SHIFT + GENE_ENVIRONMENT_BITS)
+
+#define BITS_MASK(bits) ((1u << (bits)) - 1u)
+
+static_assert(STATES_COUNT <= (1 << GENE_STATE_BITS), "Agent states don't fit into a packed gene.");
+static_assert(ENV_COUNT <= (1 << GENE_ENVIRONMENT_BITS), "Environments don't fit into a packed gene.");
+static_assert(AA_COUNT <= (1 << GENE_ACTION_BITS), "Actions don't fit into a packed gene.");
+static_assert(GENE_ACTION_SHIFT + GENE_ACTION_BITS <= 16, "Packed gene is 16 bits wide.");
+static_assert(BOARD_WIDTH <= UINT8_MAX && BOARD_HEIGHT <= UINT8_MAX, "Positions are packed into a byte.");
+static_assert(MAX_LIFETIME <= UINT16_MAX, "Lifetime and the counters bounded by it are packed into 16 bits.");
+static_assert(DC_COUNT <= UINT8_MAX, "Death cause is packed into a byte.");
+
+PackedPosition pack_position(Position pos);
+Position unpack_position(PackedPosition pos);
+
+PackedGene pack_gene(const Gene *gene) {
+	unsigned int packed = ((unsigned int)gene->current_state << GENE_CURRENT_STATE_SHIFT) |
+			      ((unsigned int)gene->next_state << GENE_NEXT_STATE_SHIFT) |
+			      ((unsigned int)gene->environment << GENE_ENVIRONMENT_SHIFT) |
+			      ((unsigned int)gene->action << GENE_ACTION_SHIFT);
+
+	return (PackedGene)packed;
+}
+
+Gene unpack_gene(PackedGene packed) {
+	Gene gene = {
+		.current_state = (AgentState)((packed >> GENE_CURRENT_STATE_SHIFT) & BITS_MASK(GENE_STATE_BITS)),
+		.next_state = (AgentState)((packed >> GENE_NEXT_STATE_SHIFT) & BITS_MASK(GENE_STATE_BITS)),
+		.environment = (Environment)((packed >> GENE_ENVIRONMENT_SHIFT) & BITS_MASK(GENE_ENVIRONMENT_BITS)),
+		.action = (AgentAction)((packed >> GENE_ACTION_SHIFT) & BITS_MASK(GENE_ACTION_BITS)),
+	};
+
+	return gene;
+}
+
+PackedPosition pack_position(Position pos) {
+	PackedPosition packed = { (uint8_t)pos.x, (uint8_t)pos.y };
+	return packed;
+}
+
+Position unpack_position(PackedPosition pos) {
+	Position result = { pos.x, pos.y };
+	return result;
+}
+
+void pack_game(const Game *game, PackedGame *packed) {
+	memset(packed, 0, sizeof(*packed));
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		const Agent *agent = &game->agents[i];
+		PackedAgent *packed_agent = &packed->agents[i];
+
+		packed_agent->pos = pack_position(agent->pos);
+		packed_agent->direction = (uint8_t)agent->direction;
+		packed_agent->current_state = (uint8_t)agent->current_state;
+		packed_agent->hunger = (int16_t)agent->hunger;
+		packed_agent->health = (int16_t)agent->health;
+		packed_agent->lifetime = (uint16_t)agent->lifetime;
+		packed_agent->death_cause = (uint8_t)agent->death_cause;
+
+		for (size_t j = 0; j < GENES_COUNT; ++j)
+			packed_agent->genes[j] = pack_gene(&game->genomes[i].genes[j]);
+	}
+
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		packed->food[i] = pack_position(game->food[i].pos);
+		packed->food_quantity[i] = (uint8_t)game->food[i].quantity;
+	}
+
+	for (size_t i = 0; i < WALLS_COUNT; ++i)
+		packed->walls[i] = pack_position(game->walls[i].pos);
+}
+
+void unpack_game(const PackedGame *packed, Game *game) {
+	memset(game, 0, sizeof(*game));
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		const PackedAgent *packed_agent = &packed->agents[i];
+		Agent *agent = &game->agents[i];
+
+		agent->index = i;
+		agent->pos = unpack_position(packed_agent->pos);
+		agent->direction = (Direction)packed_agent->direction;
+		agent->current_state = packed_agent->current_state;
+		agent->hunger = packed_agent->hunger;
+		agent->health = packed_agent->health;
+		agent->lifetime = packed_agent->lifetime;
+		agent->death_cause = (DeathCause)packed_agent->death_cause;
+
+		for (size_t j = 0; j < GENES_COUNT; ++j)
+			game->genomes[i].genes[j] = unpack_gene(packed_agent->genes[j]);
+	}
+
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		game->food[i].pos = unpack_position(packed->food[i]);
+		game->food[i].quantity = packed->food_quantity[i];
+	}
+
+	for (size_t i = 0; i < WALLS_COUNT; ++i)
+		game->walls[i].pos = unpack_position(packed->walls[i]);
+}
+
+void pack_fitness(const Game *game, PackedFitness *packed) {
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		packed->lifetimes[i] = (uint16_t)game->agents[i].lifetime;
+		packed->health[i] = (int16_t)game->agents[i].health;
+		packed->food_eaten[i] = (uint16_t)game->agents[i].food_eaten;
+		packed->attacks_dealt[i] = (uint16_t)game->agents[i].attacks_dealt;
+		packed->attacks_received[i] = (uint16_t)game->agents[i].attacks_received;
+		packed->death_causes[i] = (uint8_t)game->agents[i].death_cause;
+		memcpy(packed->gene_usage[i], game->agents[i].gene_usage, sizeof(packed->gene_usage[i]));
+	}
+}
+
+// Turns the game that was sent for evaluation into the finished one, as far as prepare_next_game can tell:
+// survivors of a game stopped early keep their health, it's what ranks them above the dead.
+void apply_fitness(const PackedFitness *packed, Game *game) {
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		game->agents[i].lifetime = packed->lifetimes[i];
+		game->agents[i].food_eaten = packed->food_eaten[i];
+		game->agents[i].attacks_dealt = packed->attacks_dealt[i];
+		game->agents[i].attacks_received = packed->attacks_received[i];
+		game->agents[i].death_cause = (DeathCause)packed->death_causes[i];
+		memcpy(game->agents[i].gene_usage, packed->gene_usage[i], sizeof(game->agents[i].gene_usage));
+		game->agents[i].health = packed->health[i];
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef PACKED_GAME_H
+#define PACKED_GAME_H
+
+#include "game.h"
+
+#include <stdint.h>
+
+// Compact copy of a game that is about to be evaluated, the way it travels between processes.
+// Only fixed-width fields, so it can be sent as-is: the whole thing is ~35 KB instead of
+// the ~630 KB of Game. History isn't packed, evaluation starts before anything happened.
+//
+// A gene is packed into 16 bits: current state, next state, environment and action.
+typedef uint16_t PackedGene;
+
+typedef struct {
+	uint8_t x;
+	uint8_t y;
+} PackedPosition;
+
+typedef struct {
+	PackedPosition pos;
+	uint8_t direction;
+	uint8_t current_state;
+	int16_t hunger;
+	int16_t health;
+	uint16_t lifetime;
+	uint8_t death_cause;
+	uint8_t padding;
+	PackedGene genes[GENES_COUNT];
+} PackedAgent;
+
+typedef struct {
+	PackedAgent agents[AGENTS_COUNT];
+	PackedPosition food[FOOD_COUNT];
+	uint8_t food_quantity[FOOD_COUNT];
+	PackedPosition walls[WALLS_COUNT];
+} PackedGame;
+
+// What evaluation gives back: everything selection needs to know about the finished game.
+// apply_fitness restores lifetime, health, death cause, the food and attack counters and gene usage;
+// position, direction, state, hunger, food and history stay as they were when the game was sent.
+typedef struct {
+	uint16_t lifetimes[AGENTS_COUNT];
+	int16_t health[AGENTS_COUNT];
+	uint16_t food_eaten[AGENTS_COUNT];
+	uint16_t attacks_dealt[AGENTS_COUNT];
+	uint16_t attacks_received[AGENTS_COUNT];
+	uint8_t death_causes[AGENTS_COUNT];
+	uint16_t gene_usage[AGENTS_COUNT][GENES_COUNT];
+} PackedFitness;
+
+PackedGene pack_gene(const Gene *gene);
+Gene unpack_gene(PackedGene packed);
+
+void pack_game(const Game *game, PackedGame *packed);
+void unpack_game(const PackedGame *packed, Game *game);
+
+void pack_fitness(const Game *game, PackedFitness *packed);
+void apply_fitness(const PackedFitness *packed, Game *game);
+
+#endif // !PACKED_GAME_H
@@ -0,0 +1,197 @@
+#include "raster.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * This is used to render pointy triangular agents,
+ * where individual triangles are fit into 0-1 coordinate system
+ *    0 - - - - -> 1
+ *    | *
+ *    | ****
+ *    | *******
+ *    | *********  <- 0.5
+ *    | *******
+ *    | ****
+ *    | *
+ *    1
+ */
+float agent_directions[4][6] = {
+	{ 0.0, 0.0, 1.0, 0.5, 0.0, 1.0 }, // DIR_RIGHT
+	{ 0.0, 1.0, 0.5, 0.0, 1.0, 1.0 }, // DIR_UP
+	{ 1.0, 0.0, 1.0, 1.0, 0.0, 0.5 }, // DIR_LEFT
+	{ 0.0, 0.0, 1.0, 0.0, 0.5, 1.0 }, // DIR_DOWN
+};
+
+void raster_blend(Raster *raster, size_t x, size_t y, uint32_t color);
+void raster_fill_rect(Raster *raster, size_t x, size_t y, size_t width, size_t height, uint32_t color);
+void raster_fill_circle(Raster *raster, float center_x, float center_y, float radius, uint32_t color);
+void raster_fill_triangle(Raster *raster, const float *vertices, uint32_t color);
+float edge_function(float ax, float ay, float bx, float by, float px, float py);
+
+void raster_scene_capture(RasterScene *scene, const Game *game, uint64_t generation, uint64_t tick) {
+	scene->generation = generation;
+	scene->tick = tick;
+	scene->agents_count = 0;
+	scene->food_count = 0;
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		const Agent *agent = &game->agents[i];
+		if (agent->health <= 0)
+			continue;
+
+		RasterAgent *captured = &scene->agents[scene->agents_count++];
+		captured->pos = (PackedPosition){ (uint8_t)agent->pos.x, (uint8_t)agent->pos.y };
+		captured->direction = (uint8_t)agent->direction;
+	}
+
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		if (game->food[i].quantity <= 0)
+			continue;
+
+		scene->food[scene->food_count++] = (PackedPosition){ (uint8_t)game->food[i].pos.x,
+								     (uint8_t)game->food[i].pos.y };
+	}
+
+	for (size_t i = 0; i < WALLS_COUNT; ++i)
+		scene->walls[i] = (PackedPosition){ (uint8_t)game->walls[i].pos.x, (uint8_t)game->walls[i].pos.y };
+}
+
+bool raster_init(Raster *raster, size_t cell_size) {
+	raster->cell_size = cell_size;
+	raster->width = BOARD_WIDTH * cell_size;
+	raster->height = BOARD_HEIGHT * cell_size;
+	raster->pixels = malloc(raster->width * raster->height * sizeof(*raster->pixels));
+
+	if (raster->pixels == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate a %zux%zu frame.\n", raster->width, raster->height);
+		return false;
+	}
+
+	return true;
+}
+
+void raster_free(Raster *raster) {
+	free(raster->pixels);
+	raster->pixels = NULL;
+}
+
+// Same order as render_game: agents, food on top of them, walls on top of everything.
+void raster_draw_scene(Raster *raster, const RasterScene *scene) {
+	const float CELL = (float)raster->cell_size;
+	const float AGENT_PADDING = 1.f;
+	const float CELL_PADDING = CELL - AGENT_PADDING * 2;
+
+	for (size_t i = 0; i < raster->width * raster->height; ++i)
+		raster->pixels[i] = BACKGROUND_COLOR;
+
+	for (size_t i = 0; i < scene->agents_count; ++i) {
+		const RasterAgent *agent = &scene->agents[i];
+		const float *shape = agent_directions[agent->direction % 4];
+		float vertices[6];
+
+		for (size_t j = 0; j < 6; j += 2) {
+			vertices[j] = shape[j] * CELL_PADDING + (float)agent->pos.x * CELL + AGENT_PADDING;
+			vertices[j + 1] = shape[j + 1] * CELL_PADDING + (float)agent->pos.y * CELL + AGENT_PADDING;
+		}
+
+		raster_fill_triangle(raster, vertices, AGENT_COLOR);
+	}
+
+	for (size_t i = 0; i < scene->food_count; ++i) {
+		raster_fill_circle(raster,
+				   (float)scene->food[i].x * CELL + CELL * 0.5f,
+				   (float)scene->food[i].y * CELL + CELL * 0.5f,
+				   floorf(CELL * 0.5f),
+				   FOOD_COLOR);
+	}
+
+	for (size_t i = 0; i < WALLS_COUNT; ++i) {
+		raster_fill_rect(raster,
+				 scene->walls[i].x * raster->cell_size,
+				 scene->walls[i].y * raster->cell_size,
+				 raster->cell_size,
+				 raster->cell_size,
+				 WALL_COLOR);
+	}
+}
+
+void raster_blend(Raster *raster, size_t x, size_t y, uint32_t color) {
+	if (x >= raster->width || y >= raster->height)
+		return;
+
+	uint32_t *pixel = &raster->pixels[y * raster->width + x];
+	*pixel = blend_color(*pixel, color);
+}
+
+uint32_t blend_color(uint32_t destination, uint32_t color) {
+	uint32_t alpha = color >> 24;
+	uint32_t result = 0xFF000000;
+
+	for (uint32_t shift = 0; shift < 24; shift += 8) {
+		uint32_t source = (color >> shift) & 0xFF;
+		uint32_t below = (destination >> shift) & 0xFF;
+		result |= ((source * alpha + below * (255 - alpha) + 127) / 255) << shift;
+	}
+
+	return result;
+}
+
+void raster_fill_rect(Raster *raster, size_t x, size_t y, size_t width, size_t height, uint32_t color) {
+	for (size_t row = y; row < y + height; ++row) {
+		for (size_t column = x; column < x + width; ++column)
+			raster_blend(raster, column, row, color);
+	}
+}
+
+// Pixels are sampled at their centers.
+void raster_fill_circle(Raster *raster, float center_x, float center_y, float radius, uint32_t color) {
+	size_t left = (size_t)fmaxf(floorf(center_x - radius), 0.f);
+	size_t top = (size_t)fmaxf(floorf(center_y - radius), 0.f);
+	size_t right = (size_t)fmaxf(ceilf(center_x + radius), 0.f);
+	size_t bottom = (size_t)fmaxf(ceilf(center_y + radius), 0.f);
+
+	for (size_t y = top; y < bottom; ++y) {
+		for (size_t x = left; x < right; ++x) {
+			float dx = (float)x + 0.5f - center_x;
+			float dy = (float)y + 0.5f - center_y;
+
+			if (dx * dx + dy * dy <= radius * radius)
+				raster_blend(raster, x, y, color);
+		}
+	}
+}
+
+void raster_fill_triangle(Raster *raster, const float *vertices, uint32_t color) {
+	const float ax = vertices[0], ay = vertices[1];
+	const float bx = vertices[2], by = vertices[3];
+	const float cx = vertices[4], cy = vertices[5];
+
+	float area = edge_function(ax, ay, bx, by, cx, cy);
+	if (area == 0.f)
+		return;
+
+	size_t left = (size_t)fmaxf(floorf(fminf(ax, fminf(bx, cx))), 0.f);
+	size_t top = (size_t)fmaxf(floorf(fminf(ay, fminf(by, cy))), 0.f);
+	size_t right = (size_t)fmaxf(ceilf(fmaxf(ax, fmaxf(bx, cx))), 0.f);
+	size_t bottom = (size_t)fmaxf(ceilf(fmaxf(ay, fmaxf(by, cy))), 0.f);
+
+	// Inside is where all three edges agree with the winding of the whole triangle.
+	for (size_t y = top; y < bottom; ++y) {
+		for (size_t x = left; x < right; ++x) {
+			float px = (float)x + 0.5f;
+			float py = (float)y + 0.5f;
+			float w0 = edge_function(bx, by, cx, cy, px, py) * area;
+			float w1 = edge_function(cx, cy, ax, ay, px, py) * area;
+			float w2 = edge_function(ax, ay, bx, by, px, py) * area;
+
+			if (w0 >= 0.f && w1 >= 0.f && w2 >= 0.f)
+				raster_blend(raster, x, y, color);
+		}
+	}
+}
+
+float edge_function(float ax, float ay, float bx, float by, float px, float py) {
+	return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
@@ -0,0 +1,51 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "game.h"
+#include "packed_game.h"
+#include "style.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RASTER_DEFAULT_CELL_SIZE 16
+
+// Vertices of the agent's triangle for every direction, shared with rendering.c.
+extern float agent_directions[4][6];
+
+typedef struct {
+	PackedPosition pos;
+	uint8_t direction;
+} RasterAgent;
+
+// Only what a frame shows, small enough to be queued by value.
+typedef struct {
+	uint64_t generation;
+	uint64_t tick;
+	uint16_t agents_count;
+	uint16_t food_count;
+	RasterAgent agents[AGENTS_COUNT];
+	PackedPosition food[FOOD_COUNT];
+	PackedPosition walls[WALLS_COUNT];
+} RasterScene;
+
+// Software counterpart of render_game for machines without a display: same colors and shapes,
+// drawn into memory with square cells of `cell_size` pixels.
+typedef struct {
+	size_t cell_size;
+	size_t width;
+	size_t height;
+	uint32_t *pixels; // 0xAARRGGBB like the colors in style.h, always opaque
+} Raster;
+
+void raster_scene_capture(RasterScene *scene, const Game *game, uint64_t generation, uint64_t tick);
+
+bool raster_init(Raster *raster, size_t cell_size);
+void raster_free(Raster *raster);
+void raster_draw_scene(Raster *raster, const RasterScene *scene);
+
+// `color` drawn over the opaque `destination` with its own alpha, the result is opaque.
+uint32_t blend_color(uint32_t destination, uint32_t color);
+
+#endif // !RASTER_H
@@ -1,33 +1,43 @@
 #include "rendering.h"
 
 #include <SDL2/SDL2_gfxPrimitives.h>
+#include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 
-#define HEX_COLOR(hex_color)                                                                               \
-	((hex_color) >> (2 * 8)) & 0xFF, ((hex_color) >> (1 * 8)) & 0xFF, ((hex_color) >> (0 * 8)) & 0xFF, \
-		((hex_color) >> (3 * 8)) & 0xFF
-
-void render_agent(SDL_Renderer *renderer, const Game *game, size_t index);
-
-/*
- * This is used to render pointy triangular agents,
- * where individual triangles are fit into 0-1 coordinate system
- *    0 - - - - -> 1
- *    | *
- *    | ****
- *    | *******
- *    | *********  <- 0.5
- *    | *******
- *    | ****
- *    | *
- *    1
- */
-float agent_directions[4][6] = {
-	{ 0.0, 0.0, 1.0, 0.5, 0.0, 1.0 }, // DIR_RIGHT
-	{ 0.0, 1.0, 0.5, 0.0, 1.0, 1.0 }, // DIR_UP
-	{ 1.0, 0.0, 1.0, 1.0, 0.0, 0.5 }, // DIR_LEFT
-	{ 0.0, 0.0, 1.0, 0.0, 0.5, 1.0 }, // DIR_DOWN
-};
+#define HEX_COLOR(hex_color)                                                                 \
+	(Uint8)(((hex_color) >> (2 * 8)) & 0xFF), (Uint8)(((hex_color) >> (1 * 8)) & 0xFF), \
+		(Uint8)(((hex_color) >> (0 * 8)) & 0xFF), (Uint8)(((hex_color) >> (3 * 8)) & 0xFF)
+
+// Cells at least partly on the screen, give or take a margin. Everything outside is skipped
+// before it costs a draw call, and before its coordinates can overflow the shorts gfx takes.
+typedef struct {
+	int min_x;
+	int min_y;
+	int max_x;
+	int max_y;
+} VisibleCells;
+
+static_assert(AGENTS_COUNT <= UINT16_MAX && FOOD_COUNT <= UINT16_MAX && WALLS_COUNT <= UINT16_MAX,
+	      "Density map counters are too narrow.");
+static_assert(MAP_ENTITIES_COUNT <= INT32_MAX, "Density map lists are too narrow.");
+
+void camera_clamp(Camera *camera);
+float camera_screen_x(const Camera *camera, float board_x);
+float camera_screen_y(const Camera *camera, float board_y);
+VisibleCells camera_visible_cells(const Camera *camera, int margin);
+bool is_cell_visible(const VisibleCells *cells, Position pos);
+
+void density_map_init(DensityMap *map);
+void density_map_update(DensityMap *map, const Game *game);
+void density_map_track(DensityMap *map, MapEntityKind kind, size_t entity, bool present, Position pos);
+void density_map_redraw_cell(DensityMap *map, Position pos);
+
+void render_density_map(SDL_Renderer *renderer, BoardView *view);
+void render_shapes(SDL_Renderer *renderer, const Camera *camera, const DensityMap *map, const Game *game);
+void render_agent(SDL_Renderer *renderer, const Camera *camera, const Agent *a);
+void render_board_outline(SDL_Renderer *renderer, const Camera *camera);
+void render_fitness_curve(SDL_Renderer *renderer, const SDL_Rect *area, const float *values, size_t count, Uint32 color);
 
 void scc(int code) // sdl check code
 {
@@ -45,64 +55,436 @@ void scp(const void *ptr) // sdl check pointer
 	}
 }
 
+BoardView *board_view_create(SDL_Renderer *renderer) {
+	BoardView *view = calloc(1, sizeof(*view));
+	scp(view);
+
+	view->density.texture = SDL_CreateTexture(
+		renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, BOARD_WIDTH, BOARD_HEIGHT);
+	scp(view->density.texture);
+	density_map_init(&view->density);
+
+	board_view_fit(view, renderer);
+	return view;
+}
+
+void board_view_destroy(BoardView *view) {
+	if (view == NULL)
+		return;
+
+	SDL_DestroyTexture(view->density.texture);
+	free(view);
+}
+
+void board_view_fit(BoardView *view, SDL_Renderer *renderer) {
+	Camera *camera = &view->camera;
+
+	scc(SDL_GetRendererOutputSize(renderer, &camera->screen_width, &camera->screen_height));
+	camera->x = 0.f;
+	camera->y = 0.f;
+	camera->cell_width = (float)camera->screen_width / BOARD_WIDTH;
+	camera->cell_height = (float)camera->screen_height / BOARD_HEIGHT;
+}
+
+void board_view_zoom(BoardView *view, float factor, int screen_x, int screen_y) {
+	Camera *camera = &view->camera;
+	float cell_size = fminf(camera->cell_width, camera->cell_height);
+
+	// A board fitted outside of the limits can still be zoomed back inside them.
+	if (factor < 1.f && cell_size * factor < CAMERA_MIN_CELL_SIZE)
+		factor = fminf(1.f, CAMERA_MIN_CELL_SIZE / cell_size);
+	if (factor > 1.f && cell_size * factor > CAMERA_MAX_CELL_SIZE)
+		factor = fmaxf(1.f, CAMERA_MAX_CELL_SIZE / cell_size);
+
+	float board_x = camera->x + (float)screen_x / camera->cell_width;
+	float board_y = camera->y + (float)screen_y / camera->cell_height;
+
+	camera->cell_width *= factor;
+	camera->cell_height *= factor;
+	camera->x = board_x - (float)screen_x / camera->cell_width;
+	camera->y = board_y - (float)screen_y / camera->cell_height;
+	camera_clamp(camera);
+}
+
+void board_view_pan(BoardView *view, float screen_dx, float screen_dy) {
+	Camera *camera = &view->camera;
+
+	camera->x -= screen_dx / camera->cell_width;
+	camera->y -= screen_dy / camera->cell_height;
+	camera_clamp(camera);
+}
+
+bool board_view_cell_at(const BoardView *view, int screen_x, int screen_y, Position *cell) {
+	const Camera *camera = &view->camera;
+	float board_x = floorf(camera->x + (float)screen_x / camera->cell_width);
+	float board_y = floorf(camera->y + (float)screen_y / camera->cell_height);
+
+	if (board_x < 0.f || board_x >= BOARD_WIDTH || board_y < 0.f || board_y >= BOARD_HEIGHT)
+		return false;
+
+	cell->x = (int16_t)board_x;
+	cell->y = (int16_t)board_y;
+	return true;
+}
+
+bool board_view_handle_event(BoardView *view, SDL_Renderer *renderer, const SDL_Event *event) {
+	switch (event->type) {
+	case SDL_MOUSEWHEEL: {
+		int mouse_x = 0;
+		int mouse_y = 0;
+		SDL_GetMouseState(&mouse_x, &mouse_y);
+		board_view_zoom(view, powf(CAMERA_ZOOM_STEP, (float)event->wheel.y), mouse_x, mouse_y);
+		return true;
+	}
+	case SDL_MOUSEMOTION: {
+		if ((event->motion.state & SDL_BUTTON_RMASK) == 0)
+			return false;
+		board_view_pan(view, (float)event->motion.xrel, (float)event->motion.yrel);
+		return true;
+	}
+	case SDL_KEYDOWN: {
+		if (event->key.keysym.sym != SDLK_0)
+			return false;
+		board_view_fit(view, renderer);
+		return true;
+	}
+	}
+
+	return false;
+}
+
+// At least one cell of the board stays on the screen, wherever it's dragged.
+void camera_clamp(Camera *camera) {
+	float visible_width = (float)camera->screen_width / camera->cell_width;
+	float visible_height = (float)camera->screen_height / camera->cell_height;
+
+	camera->x = fmaxf(1.f - visible_width, fminf(camera->x, BOARD_WIDTH - 1.f));
+	camera->y = fmaxf(1.f - visible_height, fminf(camera->y, BOARD_HEIGHT - 1.f));
+}
+
+float camera_screen_x(const Camera *camera, float board_x) {
+	return (board_x - camera->x) * camera->cell_width;
+}
+
+float camera_screen_y(const Camera *camera, float board_y) {
+	return (board_y - camera->y) * camera->cell_height;
+}
+
+VisibleCells camera_visible_cells(const Camera *camera, int margin) {
+	VisibleCells cells = {
+		(int)floorf(camera->x) - margin,
+		(int)floorf(camera->y) - margin,
+		(int)floorf(camera->x + (float)camera->screen_width / camera->cell_width) + margin,
+		(int)floorf(camera->y + (float)camera->screen_height / camera->cell_height) + margin,
+	};
+
+	return cells;
+}
+
+bool is_cell_visible(const VisibleCells *cells, Position pos) {
+	return pos.x >= cells->min_x && pos.x <= cells->max_x && pos.y >= cells->min_y && pos.y <= cells->max_y;
+}
+
+void density_map_init(DensityMap *map) {
+	for (size_t y = 0; y < BOARD_HEIGHT; ++y) {
+		for (size_t x = 0; x < BOARD_WIDTH; ++x) {
+			map->pixels[y][x] = BACKGROUND_COLOR;
+			for (size_t kind = 0; kind < MAP_KINDS_COUNT; ++kind)
+				map->first[kind][y][x] = MAP_NO_ENTITY;
+		}
+	}
+
+	map->dirty = (SDL_Rect){ 0, 0, BOARD_WIDTH, BOARD_HEIGHT };
+}
+
+void density_map_update(DensityMap *map, const Game *game) {
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		const Agent *agent = &game->agents[i];
+		density_map_track(map, MAP_AGENT, i, agent->health > 0, agent->pos);
+	}
+
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		const Food *food = &game->food[i];
+		density_map_track(map, MAP_FOOD, AGENTS_COUNT + i, food->quantity > 0, food->pos);
+	}
+
+	for (size_t i = 0; i < WALLS_COUNT; ++i)
+		density_map_track(map, MAP_WALL, AGENTS_COUNT + FOOD_COUNT + i, true, game->walls[i].pos);
+}
+
+void density_map_track(DensityMap *map, MapEntityKind kind, size_t entity, bool present, Position pos) {
+	Position *drawn_at = &map->drawn_at[entity];
+	if (map->drawn[entity] == present && (!present || (drawn_at->x == pos.x && drawn_at->y == pos.y)))
+		return;
+
+	if (map->drawn[entity]) {
+		int32_t previous = map->previous[entity];
+		int32_t next = map->next[entity];
+
+		if (previous != MAP_NO_ENTITY)
+			map->next[previous] = next;
+		else
+			map->first[kind][drawn_at->y][drawn_at->x] = next;
+		if (next != MAP_NO_ENTITY)
+			map->previous[next] = previous;
+
+		map->count[kind][drawn_at->y][drawn_at->x] -= 1;
+		density_map_redraw_cell(map, *drawn_at);
+	}
+
+	if (present) {
+		int32_t *first = &map->first[kind][pos.y][pos.x];
+
+		map->previous[entity] = MAP_NO_ENTITY;
+		map->next[entity] = *first;
+		if (*first != MAP_NO_ENTITY)
+			map->previous[*first] = (int32_t)entity;
+		*first = (int32_t)entity;
+
+		map->count[kind][pos.y][pos.x] += 1;
+		density_map_redraw_cell(map, pos);
+	}
+
+	map->drawn[entity] = present;
+	*drawn_at = pos;
+}
+
+// Stacked the way render_shapes draws them: food over agents, walls over everything.
+void density_map_redraw_cell(DensityMap *map, Position pos) {
+	uint32_t color = BACKGROUND_COLOR;
+
+	if (map->count[MAP_AGENT][pos.y][pos.x] > 0)
+		color = AGENT_COLOR;
+	if (map->count[MAP_FOOD][pos.y][pos.x] > 0)
+		color = blend_color(color, FOOD_COLOR);
+	if (map->count[MAP_WALL][pos.y][pos.x] > 0)
+		color = WALL_COLOR;
+
+	map->pixels[pos.y][pos.x] = color;
+
+	SDL_Rect *dirty = &map->dirty;
+	if (dirty->w == 0) {
+		*dirty = (SDL_Rect){ pos.x, pos.y, 1, 1 };
+		return;
+	}
+
+	int max_x = dirty->x + dirty->w > pos.x + 1 ? dirty->x + dirty->w : pos.x + 1;
+	int max_y = dirty->y + dirty->h > pos.y + 1 ? dirty->y + dirty->h : pos.y + 1;
+	dirty->x = dirty->x < pos.x ? dirty->x : pos.x;
+	dirty->y = dirty->y < pos.y ? dirty->y : pos.y;
+	dirty->w = max_x - dirty->x;
+	dirty->h = max_y - dirty->y;
+}
+
 void clear_board(SDL_Renderer *renderer) {
 	scc(SDL_SetRenderDrawColor(renderer, HEX_COLOR(BACKGROUND_COLOR)));
 	scc(SDL_RenderClear(renderer));
 }
 
-void render_agent(SDL_Renderer *renderer, const Game *game, size_t index) {
+void render_game(SDL_Renderer *renderer, BoardView *view, const Game *game) {
+	Camera *camera = &view->camera;
+
+	// The window can be resized at any moment.
+	scc(SDL_GetRendererOutputSize(renderer, &camera->screen_width, &camera->screen_height));
+
+	// Both ways of drawing need it, and keeping it up to date in both spares a rebuild when switching.
+	density_map_update(&view->density, game);
+
+	if (fminf(camera->cell_width, camera->cell_height) < DENSITY_MAP_CELL_SIZE) {
+		render_density_map(renderer, view);
+	} else {
+		render_shapes(renderer, camera, &view->density, game);
+	}
+
+	render_board_outline(renderer, camera);
+}
+
+void render_density_map(SDL_Renderer *renderer, BoardView *view) {
+	const Camera *camera = &view->camera;
+	DensityMap *map = &view->density;
+
+	if (map->dirty.w > 0) {
+		scc(SDL_UpdateTexture(
+			map->texture, &map->dirty, &map->pixels[map->dirty.y][map->dirty.x], sizeof(map->pixels[0])));
+		map->dirty = (SDL_Rect){ 0, 0, 0, 0 };
+	}
+
+	// Cells smaller than a pixel are averaged, that's what makes it a density map.
+	bool averaged = fminf(camera->cell_width, camera->cell_height) < 1.f;
+	scc(SDL_SetTextureScaleMode(map->texture, averaged ? SDL_ScaleModeLinear : SDL_ScaleModeNearest));
+
+	SDL_Rect board = {
+		(int)floorf(camera_screen_x(camera, 0.f)),
+		(int)floorf(camera_screen_y(camera, 0.f)),
+		(int)ceilf(BOARD_WIDTH * camera->cell_width),
+		(int)ceilf(BOARD_HEIGHT * camera->cell_height),
+	};
+	scc(SDL_RenderCopy(renderer, map->texture, NULL, &board));
+}
+
+// Only the cells on the screen are walked, entities anywhere else are never looked at.
+// Every kind is a pass of its own, so that they stack the way the density map shows them.
+void render_shapes(SDL_Renderer *renderer, const Camera *camera, const DensityMap *map, const Game *game) {
+	const float CELL_WIDTH = camera->cell_width;
+	const float CELL_HEIGHT = camera->cell_height;
+	VisibleCells visible = camera_visible_cells(camera, 0);
+
+	visible.min_x = visible.min_x > 0 ? visible.min_x : 0;
+	visible.min_y = visible.min_y > 0 ? visible.min_y : 0;
+	visible.max_x = visible.max_x < BOARD_WIDTH - 1 ? visible.max_x : BOARD_WIDTH - 1;
+	visible.max_y = visible.max_y < BOARD_HEIGHT - 1 ? visible.max_y : BOARD_HEIGHT - 1;
+
+	for (int y = visible.min_y; y <= visible.max_y; ++y) {
+		for (int x = visible.min_x; x <= visible.max_x; ++x) {
+			for (int32_t i = map->first[MAP_AGENT][y][x]; i != MAP_NO_ENTITY; i = map->next[i])
+				render_agent(renderer, camera, &game->agents[i]);
+		}
+	}
+
+	const float FOOD_PADDING = 0.f; // 12.5f;
+	for (int y = visible.min_y; y <= visible.max_y; ++y) {
+		for (int x = visible.min_x; x <= visible.max_x; ++x) {
+			for (int32_t i = map->first[MAP_FOOD][y][x]; i != MAP_NO_ENTITY; i = map->next[i]) {
+				filledCircleRGBA(renderer,
+						 (short)floorf(camera_screen_x(camera, (float)x) + CELL_WIDTH * 0.5f),
+						 (short)floorf(camera_screen_y(camera, (float)y) + CELL_HEIGHT * 0.5f),
+						 (short)floorf(fminf(CELL_WIDTH, CELL_HEIGHT) * 0.5f - FOOD_PADDING),
+						 HEX_COLOR(FOOD_COLOR));
+			}
+		}
+	}
+
+	const float WALL_PADDING = 0.f; // 4.0f;
+	scc(SDL_SetRenderDrawColor(renderer, HEX_COLOR(WALL_COLOR)));
+	for (int y = visible.min_y; y <= visible.max_y; ++y) {
+		for (int x = visible.min_x; x <= visible.max_x; ++x) {
+			for (int32_t i = map->first[MAP_WALL][y][x]; i != MAP_NO_ENTITY; i = map->next[i]) {
+				SDL_Rect rect = {
+					(int)floorf(camera_screen_x(camera, (float)x) + WALL_PADDING),
+					(int)floorf(camera_screen_y(camera, (float)y) + WALL_PADDING),
+					(int)floorf(CELL_WIDTH - 2 * WALL_PADDING),
+					(int)floorf(CELL_HEIGHT - 2 * WALL_PADDING),
+				};
+
+				scc(SDL_RenderFillRect(renderer, &rect));
+			}
+		}
+	}
+}
+
+void render_agent(SDL_Renderer *renderer, const Camera *camera, const Agent *a) {
 	const float AGENT_PADDING = 1.f; // 6.f;
-	const float CELL_WIDTH_PADDING = CELL_WIDTH - AGENT_PADDING * 2;
-	const float CELL_HEIGHT_PADDING = CELL_HEIGHT - AGENT_PADDING * 2;
-	const Agent *a = &game->agents[index];
+	const float CELL_WIDTH_PADDING = camera->cell_width - AGENT_PADDING * 2;
+	const float CELL_HEIGHT_PADDING = camera->cell_height - AGENT_PADDING * 2;
 
 	if (a->health <= 0)
 		return;
 
-	const short x1 = (short)(agent_directions[a->direction][0] * CELL_WIDTH_PADDING +
-				 ((float)a->pos.x * CELL_WIDTH + AGENT_PADDING));
-	const short y1 = (short)(agent_directions[a->direction][1] * CELL_HEIGHT_PADDING +
-				 ((float)a->pos.y * CELL_HEIGHT + AGENT_PADDING));
-	const short x2 = (short)(agent_directions[a->direction][2] * CELL_WIDTH_PADDING +
-				 ((float)a->pos.x * CELL_WIDTH + AGENT_PADDING));
-	const short y2 = (short)(agent_directions[a->direction][3] * CELL_HEIGHT_PADDING +
-				 ((float)a->pos.y * CELL_HEIGHT + AGENT_PADDING));
-	const short x3 = (short)(agent_directions[a->direction][4] * CELL_WIDTH_PADDING +
-				 ((float)a->pos.x * CELL_WIDTH + AGENT_PADDING));
-	const short y3 = (short)(agent_directions[a->direction][5] * CELL_HEIGHT_PADDING +
-				 ((float)a->pos.y * CELL_HEIGHT + AGENT_PADDING));
+	const float left = camera_screen_x(camera, (float)a->pos.x) + AGENT_PADDING;
+	const float top = camera_screen_y(camera, (float)a->pos.y) + AGENT_PADDING;
+	const short x1 = (short)(agent_directions[a->direction][0] * CELL_WIDTH_PADDING + left);
+	const short y1 = (short)(agent_directions[a->direction][1] * CELL_HEIGHT_PADDING + top);
+	const short x2 = (short)(agent_directions[a->direction][2] * CELL_WIDTH_PADDING + left);
+	const short y2 = (short)(agent_directions[a->direction][3] * CELL_HEIGHT_PADDING + top);
+	const short x3 = (short)(agent_directions[a->direction][4] * CELL_WIDTH_PADDING + left);
+	const short y3 = (short)(agent_directions[a->direction][5] * CELL_HEIGHT_PADDING + top);
 
 	filledTrigonRGBA(renderer, x1, y1, x2, y2, x3, y3, HEX_COLOR(AGENT_COLOR));
 	aatrigonRGBA(renderer, x1, y1, x2, y2, x3, y3, HEX_COLOR(AGENT_COLOR));
 }
 
-void render_game(SDL_Renderer *renderer, const Game *game) {
-	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
-		render_agent(renderer, game, i);
-	}
+// Zoomed out, the board doesn't fill the screen anymore.
+void render_board_outline(SDL_Renderer *renderer, const Camera *camera) {
+	SDL_Rect board = {
+		(int)floorf(camera_screen_x(camera, 0.f)) - 1,
+		(int)floorf(camera_screen_y(camera, 0.f)) - 1,
+		(int)ceilf(BOARD_WIDTH * camera->cell_width) + 2,
+		(int)ceilf(BOARD_HEIGHT * camera->cell_height) + 2,
+	};
 
-	const float FOOD_PADDING = 0.f; // 12.5f;
-	for (size_t i = 0; i < FOOD_COUNT; ++i) {
-		if (game->food[i].quantity <= 0)
-			continue;
+	scc(SDL_SetRenderDrawColor(renderer, HEX_COLOR(BOARD_OUTLINE_COLOR)));
+	scc(SDL_RenderDrawRect(renderer, &board));
+}
 
-		filledCircleRGBA(renderer,
-				 (short)floorf((float)game->food[i].pos.x * CELL_WIDTH + CELL_WIDTH * 0.5f),
-				 (short)floorf((float)game->food[i].pos.y * CELL_HEIGHT + CELL_HEIGHT * 0.5f),
-				 (short)floorf(fminf(CELL_WIDTH, CELL_HEIGHT) * 0.5f - FOOD_PADDING),
-				 HEX_COLOR(FOOD_COLOR));
-	}
+void render_agent_highlight(SDL_Renderer *renderer, const BoardView *view, const Game *game, size_t index) {
+	const Camera *camera = &view->camera;
+	const Agent *a = &game->agents[index];
+	const VisibleCells visible = camera_visible_cells(camera, 1);
 
-	const float WALL_PADDING = 0.f; // 4.0f;
-	scc(SDL_SetRenderDrawColor(renderer, HEX_COLOR(WALL_COLOR)));
-	for (size_t i = 0; i < WALLS_COUNT; ++i) {
-		SDL_Rect rect = {
-			(int)floorf((float)game->walls[i].pos.x * CELL_WIDTH + WALL_PADDING),
-			(int)floorf((float)game->walls[i].pos.y * CELL_HEIGHT + WALL_PADDING),
-			(int)floorf(CELL_WIDTH - 2 * WALL_PADDING),
-			(int)floorf(CELL_HEIGHT - 2 * WALL_PADDING),
-		};
+	if (a->health <= 0 || !is_cell_visible(&visible, a->pos))
+		return;
+
+	// Never smaller than a few pixels, the highlight has to be found on a zoomed out board too.
+	circleRGBA(renderer,
+		   (short)floorf(camera_screen_x(camera, (float)a->pos.x) + camera->cell_width * 0.5f),
+		   (short)floorf(camera_screen_y(camera, (float)a->pos.y) + camera->cell_height * 0.5f),
+		   (short)floorf(fmaxf(fmaxf(camera->cell_width, camera->cell_height), 2.f * DENSITY_MAP_CELL_SIZE)),
+		   HEX_COLOR(HIGHLIGHT_COLOR));
+}
+
+void render_fitness_curve(SDL_Renderer *renderer, const SDL_Rect *area, const float *values, size_t count, Uint32 color) {
+	SDL_Point points[256];
+	const size_t MAX_POINTS = sizeof(points) / sizeof(points[0]);
+
+	if (count < 2)
+		return;
+
+	// Plenty of samples for a curve this small, just pick the evenly spaced ones.
+	size_t points_count = count < MAX_POINTS ? count : MAX_POINTS;
+	for (size_t i = 0; i < points_count; ++i) {
+		size_t sample = i * (count - 1) / (points_count - 1);
+		float value = fminf(values[sample] / (float)MAX_LIFETIME, 1.f);
 
-		scc(SDL_RenderFillRect(renderer, &rect));
+		points[i].x = area->x + (int)((float)i * (float)(area->w - 1) / (float)(points_count - 1));
+		points[i].y = area->y + area->h - 1 - (int)(value * (float)(area->h - 1));
 	}
+
+	scc(SDL_SetRenderDrawColor(renderer, HEX_COLOR(color)));
+	scc(SDL_RenderDrawLines(renderer, points, (int)points_count));
+}
+
+// Best and mean lifetime over generations in the bottom left corner, scaled to MAX_LIFETIME.
+void render_fitness_overlay(SDL_Renderer *renderer,
+			    const float *best,
+			    const float *mean,
+			    size_t count,
+			    size_t generations_done) {
+	const int PANEL_WIDTH = 480;
+	const int PANEL_HEIGHT = 200;
+	const int PANEL_MARGIN = 16;
+	const int PANEL_PADDING = 8;
+	const int TEXT_HEIGHT = 12;
+
+	int screen_width = 0;
+	int screen_height = 0;
+	scc(SDL_GetRendererOutputSize(renderer, &screen_width, &screen_height));
+
+	SDL_Rect panel = { PANEL_MARGIN, screen_height - PANEL_HEIGHT - PANEL_MARGIN, PANEL_WIDTH, PANEL_HEIGHT };
+	SDL_Rect plot = {
+		panel.x + PANEL_PADDING,
+		panel.y + PANEL_PADDING + TEXT_HEIGHT,
+		panel.w - 2 * PANEL_PADDING,
+		panel.h - 2 * PANEL_PADDING - TEXT_HEIGHT,
+	};
+
+	scc(SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND));
+	scc(SDL_SetRenderDrawColor(renderer, HEX_COLOR(OVERLAY_BACKGROUND_COLOR)));
+	scc(SDL_RenderFillRect(renderer, &panel));
+	scc(SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE));
+
+	char caption[128];
+	snprintf(caption,
+		 sizeof(caption),
+		 "generations: %zu   best: %.0f   mean: %.1f",
+		 generations_done,
+		 count > 0 ? (double)best[count - 1] : 0.0,
+		 count > 0 ? (double)mean[count - 1] : 0.0);
+	stringRGBA(renderer,
+		   (short)(panel.x + PANEL_PADDING),
+		   (short)(panel.y + PANEL_PADDING),
+		   caption,
+		   HEX_COLOR(OVERLAY_TEXT_COLOR));
+
+	render_fitness_curve(renderer, &plot, mean, count, FITNESS_MEAN_COLOR);
+	render_fitness_curve(renderer, &plot, best, count, FITNESS_BEST_COLOR);
 }
@@ -3,6 +3,7 @@
 
 #include "style.h"
 #include "game.h"
+#include "raster.h"
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
@@ -10,13 +11,80 @@
 #define SCREEN_WIDTH 1920
 #define SCREEN_HEIGHT 1015 // apparently I am using 65px for OS header and program header in windowed mode.
 
-#define CELL_WIDTH ((float)SCREEN_WIDTH / BOARD_WIDTH)
-#define CELL_HEIGHT ((float)SCREEN_HEIGHT / BOARD_HEIGHT)
+#define CAMERA_MIN_CELL_SIZE 0.5f
+#define CAMERA_MAX_CELL_SIZE 256.f
+#define CAMERA_ZOOM_STEP 1.25f
+// Below this many pixels per cell the shapes can't be told apart, the board is drawn from the density map instead.
+#define DENSITY_MAP_CELL_SIZE 4.f
+
+// Which part of the board is on the screen: the cell at the top left corner and how big cells are.
+// Cells keep the aspect ratio they had when the board was fitted to the screen.
+typedef struct {
+	float x;
+	float y;
+	float cell_width;
+	float cell_height;
+	int screen_width;
+	int screen_height;
+} Camera;
+
+typedef enum {
+	MAP_AGENT = 0,
+	MAP_FOOD,
+	MAP_WALL,
+	MAP_KINDS_COUNT,
+} MapEntityKind;
+
+// Every entity has one index on the map: agents first, then food, then walls.
+#define MAP_ENTITIES_COUNT (AGENTS_COUNT + FOOD_COUNT + WALLS_COUNT)
+#define MAP_NO_ENTITY -1
+
+// What is on every cell of the board, kept up to date with the game one change at a time.
+//
+// Zoomed too far out for shapes, the board is drawn as a texture with a pixel per cell, and an update only
+// redraws and uploads the cells something arrived on or left. Zoomed in, the entities of every kind on a cell
+// are a linked list through their indices, so that only the cells on the screen are walked.
+typedef struct {
+	SDL_Texture *texture;
+	bool drawn[MAP_ENTITIES_COUNT];
+	Position drawn_at[MAP_ENTITIES_COUNT];
+	int32_t next[MAP_ENTITIES_COUNT]; // of the same kind on the same cell, MAP_NO_ENTITY ends the list
+	int32_t previous[MAP_ENTITIES_COUNT];
+	int32_t first[MAP_KINDS_COUNT][BOARD_HEIGHT][BOARD_WIDTH];
+	uint16_t count[MAP_KINDS_COUNT][BOARD_HEIGHT][BOARD_WIDTH];
+	uint32_t pixels[BOARD_HEIGHT][BOARD_WIDTH];
+	SDL_Rect dirty; // cells of `pixels` the texture doesn't have yet, empty when w is 0
+} DensityMap;
+
+typedef struct {
+	Camera camera;
+	DensityMap density;
+} BoardView;
 
 void scc(int code); // sdl check code
 void scp(const void *ptr); // sdl check pointer
 
+BoardView *board_view_create(SDL_Renderer *renderer);
+void board_view_destroy(BoardView *view);
+
+// Shows the whole board on the renderer's output.
+void board_view_fit(BoardView *view, SDL_Renderer *renderer);
+// Zooms around a point on the screen, the cell under it stays where it was.
+void board_view_zoom(BoardView *view, float factor, int screen_x, int screen_y);
+void board_view_pan(BoardView *view, float screen_dx, float screen_dy);
+// Returns false when the point is off the board.
+bool board_view_cell_at(const BoardView *view, int screen_x, int screen_y, Position *cell);
+// Wheel zooms, dragging with the right button pans and 0 fits the board again.
+// Returns true when the event was one of those.
+bool board_view_handle_event(BoardView *view, SDL_Renderer *renderer, const SDL_Event *event);
+
 void clear_board(SDL_Renderer *renderer);
-void render_game(SDL_Renderer *renderer, const Game *game);
+void render_game(SDL_Renderer *renderer, BoardView *view, const Game *game);
+void render_agent_highlight(SDL_Renderer *renderer, const BoardView *view, const Game *game, size_t index);
+void render_fitness_overlay(SDL_Renderer *renderer,
+			    const float *best,
+			    const float *mean,
+			    size_t count,
+			    size_t generations_done);
 
 #endif // !RENDERING_H
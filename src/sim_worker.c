@@ -0,0 +1,364 @@
+#include "sim_worker.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_SNAPSHOT_FRESH 0x4
+#define SIM_SNAPSHOT_INDEX_MASK 0x3
+#define SIM_RATE_WINDOW_SECONDS 0.5
+
+static_assert((SIM_COMMAND_QUEUE_CAPACITY & (SIM_COMMAND_QUEUE_CAPACITY - 1)) == 0,
+	      "Command queue capacity has to be a power of two.");
+static_assert(SIM_SNAPSHOT_BUFFERS - 1 <= SIM_SNAPSHOT_INDEX_MASK, "Snapshot index doesn't fit into its mask.");
+
+void *sim_worker_thread(void *arg);
+bool sim_worker_push_command(SimWorker *worker, SimCommand command);
+bool sim_worker_pop(SimWorker *worker, SimCommand *command);
+bool sim_worker_has_commands(SimWorker *worker);
+void sim_worker_wait(SimWorker *worker, const struct timespec *deadline);
+void sim_worker_apply(SimWorker *worker, const SimCommand *command);
+void sim_worker_tick(SimWorker *worker);
+void sim_worker_stop_recording(SimWorker *worker);
+bool sim_worker_publish(SimWorker *worker, bool force);
+
+struct timespec monotonic_now(void);
+struct timespec timespec_add_seconds(struct timespec t, double seconds);
+double timespec_diff_seconds(struct timespec later, struct timespec earlier);
+
+SimWorker *sim_worker_create(unsigned int seed) {
+	SimWorker *worker = calloc(1, sizeof(*worker));
+
+	if (worker == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate the simulation worker.\n");
+		return NULL;
+	}
+
+	worker->seed = seed;
+	seed_random(seed);
+	initialize_game(&worker->games[worker->current_game]);
+	worker->ticks_per_second = SIM_DEFAULT_TICKS_PER_SECOND;
+
+	worker->back = 0;
+	worker->front = SIM_SNAPSHOT_BUFFERS - 1;
+	atomic_init(&worker->middle, 1);
+	atomic_init(&worker->command_head, 0);
+	atomic_init(&worker->command_tail, 0);
+	sim_worker_publish(worker, true);
+
+	// Deadlines are computed from the monotonic clock, the condition variable has to agree with it.
+	pthread_condattr_t cond_attributes;
+	pthread_condattr_init(&cond_attributes);
+	pthread_condattr_setclock(&cond_attributes, CLOCK_MONOTONIC);
+	pthread_cond_init(&worker->wake_cond, &cond_attributes);
+	pthread_condattr_destroy(&cond_attributes);
+	pthread_mutex_init(&worker->wake_mutex, NULL);
+
+	if (pthread_create(&worker->thread, NULL, sim_worker_thread, worker) != 0) {
+		fprintf(stderr, "ERROR: Couldn't start the simulation thread.\n");
+		pthread_cond_destroy(&worker->wake_cond);
+		pthread_mutex_destroy(&worker->wake_mutex);
+		free(worker);
+		return NULL;
+	}
+
+	return worker;
+}
+
+void sim_worker_destroy(SimWorker *worker) {
+	if (worker == NULL)
+		return;
+
+	while (!sim_worker_push(worker, SC_QUIT, 0))
+		sched_yield();
+
+	pthread_join(worker->thread, NULL);
+
+	// Games nobody got to apply still belong to the queue.
+	SimCommand command;
+	while (sim_worker_pop(worker, &command))
+		free(command.game);
+
+	pthread_cond_destroy(&worker->wake_cond);
+	pthread_mutex_destroy(&worker->wake_mutex);
+	free(worker);
+}
+
+bool sim_worker_push(SimWorker *worker, SimCommandType type, int argument) {
+	return sim_worker_push_command(worker, (SimCommand){ type, argument, NULL, 0 });
+}
+
+// `game` has to be allocated with malloc, the worker frees it once it's applied.
+// On failure the caller keeps the ownership.
+bool sim_worker_push_game(SimWorker *worker, Game *game, size_t generation) {
+	return sim_worker_push_command(worker, (SimCommand){ SC_REPLACE_GAME, 0, game, generation });
+}
+
+bool sim_worker_push_command(SimWorker *worker, SimCommand command) {
+	size_t head = atomic_load_explicit(&worker->command_head, memory_order_relaxed);
+	size_t tail = atomic_load_explicit(&worker->command_tail, memory_order_acquire);
+
+	if (head - tail == SIM_COMMAND_QUEUE_CAPACITY)
+		return false;
+
+	worker->commands[head & (SIM_COMMAND_QUEUE_CAPACITY - 1)] = command;
+	atomic_store_explicit(&worker->command_head, head + 1, memory_order_release);
+
+	// The lock is only here to not lose a wakeup of the sleeping worker,
+	// it's never held while the worker is simulating.
+	pthread_mutex_lock(&worker->wake_mutex);
+	pthread_cond_signal(&worker->wake_cond);
+	pthread_mutex_unlock(&worker->wake_mutex);
+
+	return true;
+}
+
+SimSnapshot *sim_worker_acquire_snapshot(SimWorker *worker, bool *is_new) {
+	bool fresh = (atomic_load_explicit(&worker->middle, memory_order_relaxed) & SIM_SNAPSHOT_FRESH) != 0;
+
+	if (fresh) {
+		int previous = atomic_exchange_explicit(&worker->middle, worker->front, memory_order_acq_rel);
+		worker->front = previous & SIM_SNAPSHOT_INDEX_MASK;
+	}
+
+	if (is_new != NULL)
+		*is_new = fresh;
+
+	return &worker->snapshots[worker->front];
+}
+
+bool sim_worker_pop(SimWorker *worker, SimCommand *command) {
+	size_t tail = atomic_load_explicit(&worker->command_tail, memory_order_relaxed);
+	size_t head = atomic_load_explicit(&worker->command_head, memory_order_acquire);
+
+	if (head == tail)
+		return false;
+
+	*command = worker->commands[tail & (SIM_COMMAND_QUEUE_CAPACITY - 1)];
+	atomic_store_explicit(&worker->command_tail, tail + 1, memory_order_release);
+	return true;
+}
+
+bool sim_worker_has_commands(SimWorker *worker) {
+	return atomic_load_explicit(&worker->command_head, memory_order_acquire) !=
+	       atomic_load_explicit(&worker->command_tail, memory_order_relaxed);
+}
+
+// Sleeps until a command arrives or the deadline passes, NULL deadline means "until a command arrives".
+void sim_worker_wait(SimWorker *worker, const struct timespec *deadline) {
+	pthread_mutex_lock(&worker->wake_mutex);
+
+	while (!sim_worker_has_commands(worker)) {
+		if (deadline == NULL) {
+			pthread_cond_wait(&worker->wake_cond, &worker->wake_mutex);
+		} else if (pthread_cond_timedwait(&worker->wake_cond, &worker->wake_mutex, deadline) == ETIMEDOUT) {
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&worker->wake_mutex);
+}
+
+void sim_worker_apply(SimWorker *worker, const SimCommand *command) {
+	Game *game = &worker->games[worker->current_game];
+
+	switch (command->type) {
+	case SC_STEP:
+		if (!is_everyone_dead(game))
+			sim_worker_tick(worker);
+		break;
+
+	case SC_SET_RUNNING: worker->running = command->argument != 0; break;
+
+	case SC_TOGGLE_RUNNING: worker->running = !worker->running; break;
+
+	case SC_SET_RATE:
+		worker->ticks_per_second = command->argument;
+		if (worker->ticks_per_second < 0)
+			worker->ticks_per_second = 1;
+		if (worker->ticks_per_second > SIM_MAX_TICKS_PER_SECOND)
+			worker->ticks_per_second = SIM_MAX_TICKS_PER_SECOND;
+		break;
+
+	case SC_REGENERATE:
+		sim_worker_stop_recording(worker);
+		initialize_game(game);
+		worker->tick = 0;
+		worker->generation = 0;
+		break;
+
+	case SC_NEXT_GENERATION: {
+		int next = 1 - worker->current_game;
+		sim_worker_stop_recording(worker);
+		print_the_state_of_oldest_agent(game);
+		prepare_next_game(game, &worker->games[next]);
+		worker->current_game = next;
+		worker->tick = 0;
+		worker->generation += 1;
+	} break;
+
+	case SC_LOAD:
+		sim_worker_stop_recording(worker);
+		// A save that doesn't fit this build leaves the current game going.
+		if (load_game_state(GAME_STATE_FILEPATH, game))
+			worker->tick = 0;
+		break;
+
+	case SC_REPLACE_GAME:
+		sim_worker_stop_recording(worker);
+		memcpy(game, command->game, sizeof(*game));
+		free(command->game);
+		worker->tick = 0;
+		worker->generation = command->generation;
+		break;
+
+	case SC_TOGGLE_RECORDING:
+		if (worker->recording) {
+			sim_worker_stop_recording(worker);
+		} else {
+			// A log describes a single game from the tick it was started at.
+			worker->recording = event_log_open(
+				&worker->log, EVENT_LOG_FILEPATH, game, EVENT_LOG_DEFAULT_KEYFRAME_INTERVAL);
+		}
+		break;
+
+	case SC_QUIT:
+		sim_worker_stop_recording(worker);
+		worker->quit = true;
+		break;
+
+	default: assert(0 && "This is not supposed to happen, fix the command type."); break;
+	}
+}
+
+void sim_worker_tick(SimWorker *worker) {
+	game_step_logged(&worker->games[worker->current_game], worker->recording ? &worker->log : NULL);
+	worker->tick += 1;
+}
+
+void sim_worker_stop_recording(SimWorker *worker) {
+	if (!worker->recording)
+		return;
+
+	event_log_close(&worker->log);
+	worker->recording = false;
+}
+
+// Without `force` the snapshot is skipped while the reader still hasn't picked up the previous one,
+// there is no point in copying the whole game faster than somebody can look at it.
+bool sim_worker_publish(SimWorker *worker, bool force) {
+	if (!force && (atomic_load_explicit(&worker->middle, memory_order_relaxed) & SIM_SNAPSHOT_FRESH) != 0)
+		return false;
+
+	SimSnapshot *snapshot = &worker->snapshots[worker->back];
+	memcpy(&snapshot->game, &worker->games[worker->current_game], sizeof(snapshot->game));
+	snapshot->tick = worker->tick;
+	snapshot->generation = worker->generation;
+	snapshot->running = worker->running;
+	snapshot->recording = worker->recording;
+	snapshot->ticks_per_second = worker->ticks_per_second;
+	snapshot->measured_ticks_per_second = worker->measured_ticks_per_second;
+
+	int previous =
+		atomic_exchange_explicit(&worker->middle, worker->back | SIM_SNAPSHOT_FRESH, memory_order_acq_rel);
+	worker->back = previous & SIM_SNAPSHOT_INDEX_MASK;
+
+	return true;
+}
+
+void *sim_worker_thread(void *arg) {
+	SimWorker *worker = arg;
+	seed_random(worker->seed + 1);
+
+	struct timespec next_tick = monotonic_now();
+	struct timespec rate_window_start = next_tick;
+	size_t rate_window_ticks = worker->tick;
+	bool dirty = false;
+
+	while (!worker->quit) {
+		SimCommand command;
+		while (sim_worker_pop(worker, &command)) {
+			sim_worker_apply(worker, &command);
+			dirty = true;
+		}
+
+		if (worker->quit)
+			break;
+
+		if (worker->running && is_everyone_dead(&worker->games[worker->current_game])) {
+			worker->running = false;
+			dirty = true;
+		}
+
+		struct timespec now = monotonic_now();
+		double window = timespec_diff_seconds(now, rate_window_start);
+		if (window >= SIM_RATE_WINDOW_SECONDS || !worker->running) {
+			worker->measured_ticks_per_second =
+				worker->running ? (float)((double)(worker->tick - rate_window_ticks) / window) : 0.f;
+			rate_window_start = now;
+			rate_window_ticks = worker->tick;
+		}
+
+		if (!worker->running) {
+			if (dirty)
+				sim_worker_publish(worker, true);
+			dirty = false;
+
+			sim_worker_wait(worker, NULL);
+			next_tick = monotonic_now();
+			continue;
+		}
+
+		if (worker->ticks_per_second != SIM_UNLIMITED_TICKS_PER_SECOND) {
+			if (timespec_diff_seconds(next_tick, now) > 0.0) {
+				if (dirty)
+					sim_worker_publish(worker, true);
+				dirty = false;
+
+				sim_worker_wait(worker, &next_tick);
+				continue;
+			}
+
+			next_tick = timespec_add_seconds(next_tick, 1.0 / worker->ticks_per_second);
+			// Don't try to catch up after we fell behind (slow machine, huge rate, etc.).
+			if (timespec_diff_seconds(now, next_tick) > 1.0)
+				next_tick = now;
+		}
+
+		sim_worker_tick(worker);
+		dirty = true;
+
+		if (sim_worker_publish(worker, false))
+			dirty = false;
+	}
+
+	return NULL;
+}
+
+struct timespec monotonic_now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now;
+}
+
+struct timespec timespec_add_seconds(struct timespec t, double seconds) {
+	const long NANOSECONDS_IN_SECOND = 1000000000L;
+	long whole = (long)seconds;
+
+	t.tv_sec += whole;
+	t.tv_nsec += (long)((seconds - (double)whole) * (double)NANOSECONDS_IN_SECOND);
+	if (t.tv_nsec >= NANOSECONDS_IN_SECOND) {
+		t.tv_sec += 1;
+		t.tv_nsec -= NANOSECONDS_IN_SECOND;
+	}
+
+	return t;
+}
+
+double timespec_diff_seconds(struct timespec later, struct timespec earlier) {
+	return (double)(later.tv_sec - earlier.tv_sec) + (double)(later.tv_nsec - earlier.tv_nsec) * 1e-9;
+}
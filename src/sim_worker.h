@@ -0,0 +1,91 @@
+#ifndef SIM_WORKER_H
+#define SIM_WORKER_H
+
+#include "event_log.h"
+#include "game.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SIM_COMMAND_QUEUE_CAPACITY 64 // has to be a power of two
+#define SIM_SNAPSHOT_BUFFERS 3
+#define SIM_DEFAULT_TICKS_PER_SECOND 8
+#define SIM_MAX_TICKS_PER_SECOND 4096
+#define SIM_UNLIMITED_TICKS_PER_SECOND 0
+
+typedef enum {
+	SC_STEP = 0,
+	SC_SET_RUNNING,
+	SC_TOGGLE_RUNNING,
+	SC_SET_RATE, // argument is ticks per second, SIM_UNLIMITED_TICKS_PER_SECOND means "as fast as possible"
+	SC_REGENERATE,
+	SC_NEXT_GENERATION,
+	SC_LOAD,
+	SC_REPLACE_GAME, // takes the ownership of `game` and shows `generation`
+	SC_TOGGLE_RECORDING, // event log of the current game into EVENT_LOG_FILEPATH
+	SC_QUIT,
+} SimCommandType;
+
+typedef struct {
+	SimCommandType type;
+	int argument;
+	Game *game; // SC_REPLACE_GAME only
+	size_t generation; // SC_REPLACE_GAME only
+} SimCommand;
+
+// Immutable copy of the worker's state. Once published, the worker never touches it
+// until the reader gives it back by acquiring a newer one.
+typedef struct {
+	Game game;
+	size_t tick;
+	size_t generation;
+	bool running;
+	bool recording;
+	int ticks_per_second;
+	float measured_ticks_per_second;
+} SimSnapshot;
+
+// The worker owns the game and steps it on its own thread.
+//
+// UI -> worker: single-producer/single-consumer command ring, the worker only sleeps
+// on the condition variable when it has nothing to do.
+// worker -> UI: triple buffer of snapshots, both sides only exchange buffer indexes
+// through `middle`, so the reader never takes a lock and never waits for a tick.
+typedef struct {
+	pthread_t thread;
+	pthread_mutex_t wake_mutex;
+	pthread_cond_t wake_cond;
+
+	SimCommand commands[SIM_COMMAND_QUEUE_CAPACITY];
+	atomic_size_t command_head; // written by the UI
+	atomic_size_t command_tail; // written by the worker
+
+	SimSnapshot snapshots[SIM_SNAPSHOT_BUFFERS];
+	atomic_int middle; // index of the buffer in the middle, SIM_SNAPSHOT_FRESH bit marks unread snapshot
+	int back; // owned by the worker
+	int front; // owned by the reader
+
+	// Everything below is owned by the worker thread.
+	unsigned int seed;
+	Game games[2];
+	int current_game;
+	size_t tick;
+	size_t generation;
+	bool running;
+	int ticks_per_second;
+	float measured_ticks_per_second;
+	bool recording;
+	EventLog log;
+	bool quit;
+} SimWorker;
+
+SimWorker *sim_worker_create(unsigned int seed);
+void sim_worker_destroy(SimWorker *worker);
+
+bool sim_worker_push(SimWorker *worker, SimCommandType type, int argument);
+bool sim_worker_push_game(SimWorker *worker, Game *game, size_t generation);
+SimSnapshot *sim_worker_acquire_snapshot(SimWorker *worker, bool *is_new);
+
+#endif // !SIM_WORKER_H
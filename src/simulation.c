@@ -1,20 +1,324 @@
+#include "./event_log.h"
+#include "./evolution.h"
 #include "./game.h"
 #include "./rendering.h"
+#include "./sim_worker.h"
 
 #include "SDL_events.h"
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+// The UI doesn't redraw unless something changed, it only wakes up this often to look for a new snapshot.
+#define SNAPSHOT_POLL_INTERVAL_MS 16
+#define REPLAY_TICKS_PER_SECOND 8
+
+typedef struct {
+	SimWorker *worker;
+	SimSnapshot *snapshot;
+	BoardView *view;
+	int quit;
+
+	// Fast-forward evolution runs on its own threads, the board shows replays of its best generation.
+	Evolution *evolution;
+	size_t replay_version;
+	size_t replay_agent_index;
+	bool has_replay;
+	size_t generations_done;
+	size_t history_count;
+	float history_best[EVOLUTION_HISTORY_CAPACITY];
+	float history_mean[EVOLUTION_HISTORY_CAPACITY];
+} Viewer;
+
+void handle_event(Viewer *viewer, const SDL_Event *event);
+void inspect_cell(const BoardView *view, Game *game, int screen_x, int screen_y);
+void toggle_evolution(Viewer *viewer);
+bool update_evolution(Viewer *viewer);
+void update_window_title(SDL_Window *window, const SimSnapshot *snapshot);
+int run_replay(SDL_Window *window, SDL_Renderer *renderer, BoardView *view, const char *filepath);
+
+void handle_event(Viewer *viewer, const SDL_Event *event) {
+	SimWorker *worker = viewer->worker;
+	SimSnapshot *snapshot = viewer->snapshot;
+
+	switch (event->type) {
+	case SDL_QUIT: {
+		viewer->quit = 1;
+	} break;
+	case SDL_KEYDOWN: {
+		switch (event->key.keysym.sym) {
+		case SDLK_q: {
+			viewer->quit = 1;
+		} break;
+		case SDLK_r: {
+			sim_worker_push(worker, SC_REGENERATE, 0);
+			viewer->has_replay = false;
+		} break;
+		case SDLK_s: {
+			sim_worker_push(worker, SC_STEP, 0);
+		} break;
+		case SDLK_SPACE: {
+			sim_worker_push(worker, SC_TOGGLE_RUNNING, 0);
+		} break;
+		case SDLK_EQUALS:
+		case SDLK_PLUS:
+		case SDLK_KP_PLUS: {
+			int rate = snapshot->ticks_per_second == SIM_UNLIMITED_TICKS_PER_SECOND ?
+					   SIM_MAX_TICKS_PER_SECOND :
+					   snapshot->ticks_per_second * 2;
+			sim_worker_push(worker, SC_SET_RATE, rate);
+		} break;
+		case SDLK_MINUS:
+		case SDLK_KP_MINUS: {
+			int rate = snapshot->ticks_per_second == SIM_UNLIMITED_TICKS_PER_SECOND ?
+					   SIM_MAX_TICKS_PER_SECOND :
+					   snapshot->ticks_per_second / 2;
+			sim_worker_push(worker, SC_SET_RATE, rate > 0 ? rate : 1);
+		} break;
+		case SDLK_f: {
+			sim_worker_push(worker, SC_SET_RATE, SIM_UNLIMITED_TICKS_PER_SECOND);
+		} break;
+		case SDLK_d: {
+			dump_game_state(GAME_STATE_FILEPATH, &snapshot->game);
+		} break;
+		case SDLK_l: {
+			sim_worker_push(worker, SC_LOAD, 0);
+			viewer->has_replay = false;
+		} break;
+		case SDLK_n: {
+			sim_worker_push(worker, SC_NEXT_GENERATION, 0);
+			viewer->has_replay = false;
+		} break;
+		case SDLK_e: {
+			toggle_evolution(viewer);
+		} break;
+		case SDLK_c: {
+			sim_worker_push(worker, SC_TOGGLE_RECORDING, 0);
+		} break;
+		}
+	} break;
+	case SDL_MOUSEBUTTONDOWN: {
+		if (event->button.button == SDL_BUTTON_LEFT)
+			inspect_cell(viewer->view, &snapshot->game, event->button.x, event->button.y);
+	} break;
+	}
+}
+
+void inspect_cell(const BoardView *view, Game *game, int screen_x, int screen_y) {
+	Position click_pos;
+	if (!board_view_cell_at(view, screen_x, screen_y, &click_pos))
+		return;
+
+	Agent *agent_at_pos = get_ptr_to_agent_at_pos(game, click_pos);
+	Food *food_at_pos = get_ptr_to_food_at_pos(game, click_pos);
+	Wall *wall_at_pos = get_ptr_to_wall_at_pos(game, click_pos);
+
+	if (agent_at_pos != NULL) {
+		print_agent_verbose(stdout, agent_at_pos, &game->genomes[agent_at_pos - game->agents]);
+	}
+	if (food_at_pos != NULL) {
+		fprintf(stdout,
+			"Food at [%d;%d] with quantity: %d\n",
+			food_at_pos->pos.x,
+			food_at_pos->pos.y,
+			food_at_pos->quantity);
+	}
+	if (wall_at_pos != NULL) {
+		fprintf(stdout, "Wall at [%d;%d]\n", wall_at_pos->pos.x, wall_at_pos->pos.y);
+	}
+
+	fflush(stdout);
+}
+
+void toggle_evolution(Viewer *viewer) {
+	if (viewer->evolution != NULL) {
+		evolution_stop(viewer->evolution);
+		viewer->evolution = NULL;
+		viewer->has_replay = false;
+		return;
+	}
+
+	size_t islands_count = evolution_default_islands_count();
+	viewer->evolution = evolution_start(&viewer->snapshot->game, islands_count, (unsigned int)time(0));
+	viewer->replay_version = 0;
+	viewer->generations_done = 0;
+	viewer->history_count = 0;
+
+	if (viewer->evolution != NULL)
+		fprintf(stdout, "INFO: Fast-forward evolution started on %zu islands.\n", islands_count);
+}
+
+// Once the previous replay has played out, the best generation found so far is replayed from its start.
+// Returns true when the overlay has something new to show.
+bool update_evolution(Viewer *viewer) {
+	if (viewer->evolution == NULL)
+		return false;
+
+	size_t version = evolution_best_version(viewer->evolution);
+	if (version != viewer->replay_version && !viewer->snapshot->running) {
+		Game *replay = malloc(sizeof(*replay));
+		size_t generation = 0;
+		size_t best_agent_index = 0;
+
+		// The highlight only moves once the replay it belongs to is on its way to the worker.
+		if (replay != NULL && evolution_copy_best(viewer->evolution, replay, &generation, &best_agent_index) &&
+		    sim_worker_push_game(viewer->worker, replay, generation)) {
+			sim_worker_push(viewer->worker, SC_SET_RUNNING, 1);
+			viewer->replay_agent_index = best_agent_index;
+			viewer->replay_version = version;
+			viewer->has_replay = true;
+		} else {
+			free(replay);
+		}
+	}
+
+	size_t generations_done = evolution_generations_done(viewer->evolution);
+	if (generations_done == viewer->generations_done)
+		return false;
+
+	viewer->generations_done = generations_done;
+	viewer->history_count = evolution_copy_history(
+		viewer->evolution, viewer->history_best, viewer->history_mean, EVOLUTION_HISTORY_CAPACITY);
+	return true;
+}
+
+void update_window_title(SDL_Window *window, const SimSnapshot *snapshot) {
+	char title[256];
+
+	if (snapshot->ticks_per_second == SIM_UNLIMITED_TICKS_PER_SECOND) {
+		snprintf(title,
+			 sizeof(title),
+			 "QM's playground | generation %zu | tick %zu | %s | unlimited (%.0f ticks/s)%s",
+			 snapshot->generation,
+			 snapshot->tick,
+			 snapshot->running ? "running" : "paused",
+			 (double)snapshot->measured_ticks_per_second,
+			 snapshot->recording ? " | recording" : "");
+	} else {
+		snprintf(title,
+			 sizeof(title),
+			 "QM's playground | generation %zu | tick %zu | %s | %d ticks/s%s",
+			 snapshot->generation,
+			 snapshot->tick,
+			 snapshot->running ? "running" : "paused",
+			 snapshot->ticks_per_second,
+			 snapshot->recording ? " | recording" : "");
+	}
+
+	SDL_SetWindowTitle(window, title);
+}
+
+// Plays an event log back. Every frame is decoded from the closest keyframe, so seeking anywhere is cheap.
+int run_replay(SDL_Window *window, SDL_Renderer *renderer, BoardView *view, const char *filepath) {
+	EventReplay replay;
+	if (!event_replay_open(&replay, filepath))
+		return 1;
+
+	Game *game = malloc(sizeof(*game));
+	if (game == NULL) {
+		event_replay_close(&replay);
+		return 1;
+	}
+
+	const Uint32 TICK_INTERVAL_MS = 1000 / REPLAY_TICKS_PER_SECOND;
+	uint32_t tick = 0;
+	bool playing = false;
+	bool seek = true;
+	Uint32 last_tick_time = SDL_GetTicks();
+	int quit = 0;
+
+	while (!quit) {
+		SDL_Event event;
+		bool redraw = false;
+
+		while (SDL_WaitEventTimeout(&event, playing ? (int)TICK_INTERVAL_MS : SNAPSHOT_POLL_INTERVAL_MS)) {
+			uint32_t previous_tick = tick;
+			const uint32_t KEYFRAME_STEP = replay.keyframe_interval;
+
+			if (board_view_handle_event(view, renderer, &event)) {
+				// Only the camera moved.
+			} else if (event.type == SDL_QUIT) {
+				quit = 1;
+			} else if (event.type == SDL_KEYDOWN) {
+				switch (event.key.keysym.sym) {
+				case SDLK_q: quit = 1; break;
+				case SDLK_SPACE: playing = !playing; break;
+				case SDLK_RIGHT: tick = tick < replay.ticks_count ? tick + 1 : tick; break;
+				case SDLK_LEFT: tick = tick > 0 ? tick - 1 : tick; break;
+				case SDLK_UP:
+					tick = replay.ticks_count - tick > KEYFRAME_STEP ? tick + KEYFRAME_STEP :
+											   replay.ticks_count;
+					break;
+				case SDLK_DOWN: tick = tick > KEYFRAME_STEP ? tick - KEYFRAME_STEP : 0; break;
+				case SDLK_HOME: tick = 0; break;
+				case SDLK_END: tick = replay.ticks_count; break;
+				}
+			} else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT) {
+				// Keyframes don't carry the history, inspection decodes everything from the start.
+				Game *inspected = malloc(sizeof(*inspected));
+				if (inspected != NULL && event_replay_seek_with_history(&replay, tick, inspected))
+					inspect_cell(view, inspected, event.button.x, event.button.y);
+				free(inspected);
+			}
+
+			seek = seek || tick != previous_tick;
+			redraw = true;
+			if (!SDL_PollEvent(NULL))
+				break;
+		}
+
+		if (playing && SDL_GetTicks() - last_tick_time >= TICK_INTERVAL_MS) {
+			last_tick_time = SDL_GetTicks();
+			if (tick < replay.ticks_count) {
+				tick += 1;
+				seek = true;
+			} else {
+				playing = false;
+			}
+		}
+
+		if (seek) {
+			if (!event_replay_seek(&replay, tick, game))
+				fprintf(stderr, "ERROR: The event log is corrupted around tick %u.\n", tick);
+
+			char title[256];
+			snprintf(title, sizeof(title), "QM's playground | replay | tick %u / %u", tick, replay.ticks_count);
+			SDL_SetWindowTitle(window, title);
+			seek = false;
+			redraw = true;
+		}
+
+		if (!redraw)
+			continue;
+
+		clear_board(renderer);
+		render_game(renderer, view, game);
+		SDL_RenderPresent(renderer);
+	}
+
+	free(game);
+	event_replay_close(&replay);
+	return 0;
+}
+
 int main(int argc, char *argv[]) {
-	(void)argc;
-	(void)argv;
+	const char *replay_filepath = NULL;
+	if (argc == 3 && strcmp(argv[1], "--replay") == 0) {
+		replay_filepath = argv[2];
+	} else if (argc != 1) {
+		fprintf(stderr, "Usage: %s [--replay %s]\n", argv[0], EVENT_LOG_FILEPATH);
+		return 1;
+	}
 
-	srand((unsigned int)time(0));
+	unsigned int seed = (unsigned int)time(0);
+	seed_random(seed);
 
-	Game games[2] = { 0 };
-	int current_game = 0;
-	initialize_game(&games[current_game]);
+	// Heap allocated, the viewer keeps the histories for the overlay.
+	Viewer *viewer = calloc(1, sizeof(*viewer));
+	if (viewer == NULL)
+		return 1;
 
 	scc(SDL_Init(SDL_INIT_VIDEO));
 
@@ -25,76 +329,70 @@ int main(int argc, char *argv[]) {
 	SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 	scp(renderer);
 
-	int quit = 0;
-	while (!quit) {
+	viewer->view = board_view_create(renderer);
+
+	if (replay_filepath != NULL) {
+		int result = run_replay(window, renderer, viewer->view, replay_filepath);
+		board_view_destroy(viewer->view);
+		free(viewer);
+		SDL_Quit();
+		return result;
+	}
+
+	viewer->worker = sim_worker_create(seed);
+	if (viewer->worker == NULL)
+		return 1;
+
+	bool redraw = true;
+	viewer->snapshot = sim_worker_acquire_snapshot(viewer->worker, NULL);
+	while (!viewer->quit) {
 		SDL_Event event;
 
-		while (SDL_PollEvent(&event)) {
-			switch (event.type) {
-			case SDL_QUIT: {
-				quit = 1;
-			} break;
-			case SDL_KEYDOWN: {
-				switch (event.key.keysym.sym) {
-				case SDLK_q: {
-					quit = 1;
-				} break;
-				case SDLK_r: {
-					initialize_game(&games[current_game]);
-				} break;
-				case SDLK_s: { // qm_todo: later on, make the ticks automatic after delta t, not manual.
-					game_step(&games[current_game]);
-				} break;
-				case SDLK_d: {
-					dump_game_state("./output/game_state.bin", &games[current_game]);
-				} break;
-				case SDLK_l: {
-					load_game_state("./output/game_state.bin", &games[current_game]);
-				} break;
-				case SDLK_n: {
-					int next = 1 - current_game;
-					print_the_state_of_oldest_agent(&games[current_game]);
-					prepare_next_game(&games[current_game], &games[next]);
-					current_game = next;
-				} break;
-				}
-			} break;
-			case SDL_MOUSEBUTTONDOWN: {
-				Position click_pos = {
-					(int)floorf((float)event.button.x / CELL_WIDTH),
-					(int)floorf((float)event.button.y / CELL_HEIGHT),
-				};
-
-				Agent *agent_at_pos = get_ptr_to_agent_at_pos(&games[current_game], click_pos);
-				Food *food_at_pos = get_ptr_to_food_at_pos(&games[current_game], click_pos);
-				Wall *wall_at_pos = get_ptr_to_wall_at_pos(&games[current_game], click_pos);
-
-				if (agent_at_pos != NULL) {
-					print_agent_verbose(stdout, agent_at_pos);
-				}
-				if (food_at_pos != NULL) {
-					fprintf(stdout,
-						"Food at [%d;%d] with quantity: %d\n",
-						food_at_pos->pos.x,
-						food_at_pos->pos.y,
-						food_at_pos->quantity);
-				}
-				if (wall_at_pos != NULL) {
-					fprintf(stdout, "Wall at [%d;%d]\n", wall_at_pos->pos.x, wall_at_pos->pos.y);
-				}
+		if (SDL_WaitEventTimeout(&event, SNAPSHOT_POLL_INTERVAL_MS)) {
+			do {
+				if (!board_view_handle_event(viewer->view, renderer, &event))
+					handle_event(viewer, &event);
+			} while (SDL_PollEvent(&event));
+			redraw = true;
+		}
 
-				fflush(stdout);
-			} break;
-			}
+		bool is_new = false;
+		viewer->snapshot = sim_worker_acquire_snapshot(viewer->worker, &is_new);
+		if (is_new) {
+			update_window_title(window, viewer->snapshot);
+			redraw = true;
 		}
 
+		if (update_evolution(viewer))
+			redraw = true;
+
+		if (!redraw)
+			continue;
+
 		clear_board(renderer);
-		render_game(renderer, &games[current_game]);
+		render_game(renderer, viewer->view, &viewer->snapshot->game);
+
+		if (viewer->has_replay)
+			render_agent_highlight(
+				renderer, viewer->view, &viewer->snapshot->game, viewer->replay_agent_index);
+
+		if (viewer->evolution != NULL) {
+			render_fitness_overlay(renderer,
+					       viewer->history_best,
+					       viewer->history_mean,
+					       viewer->history_count,
+					       viewer->generations_done);
+		}
 
 		SDL_RenderPresent(renderer);
+		redraw = false;
 	}
 
-	print_the_state_of_oldest_agent(&games[current_game]);
+	evolution_stop(viewer->evolution);
+	print_the_state_of_oldest_agent(&viewer->snapshot->game);
+	sim_worker_destroy(viewer->worker);
+	board_view_destroy(viewer->view);
+	free(viewer);
 
 	SDL_Quit();
 	return 0;
@@ -0,0 +1,105 @@
+#include "stats.h"
+
+#include <assert.h>
+#include <string.h>
+
+static_assert(MAX_LIFETIME % STATS_ALIVE_CURVE_POINTS == 0, "Alive curve has to split the lifetime evenly.");
+static_assert(AGENTS_COUNT <= UINT8_MAX, "Gene counts of a chromosome position are 8 bits wide.");
+
+uint32_t lifetime_percentile(const uint32_t *histogram, uint32_t agents_count, uint32_t percent);
+size_t gene_key(const Gene *gene);
+
+void generation_stats_compute(GenerationStats *stats, Game *const games[], size_t games_count) {
+	// Lifetimes are bounded, so a histogram gives all the percentiles without sorting anything.
+	uint32_t histogram[MAX_LIFETIME + 1] = { 0 };
+	uint64_t lifetime_sum = 0;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->islands_count = (uint32_t)games_count;
+
+	for (size_t i = 0; i < games_count; ++i) {
+		size_t game_ticks = 0;
+		stats->diversity += genome_diversity(games[i]) / (float)games_count;
+
+		for (size_t j = 0; j < AGENTS_COUNT; ++j) {
+			const Agent *agent = &games[i]->agents[j];
+			size_t lifetime = agent->lifetime <= MAX_LIFETIME ? agent->lifetime : MAX_LIFETIME;
+
+			histogram[lifetime] += 1;
+			lifetime_sum += lifetime;
+			stats->food_eaten += agent->food_eaten;
+			stats->attacks += agent->attacks_dealt;
+			stats->deaths[agent->death_cause] += 1;
+
+			// The game is over right after the tick its last agent died on.
+			if (lifetime > game_ticks)
+				game_ticks = lifetime;
+		}
+
+		stats->ticks += game_ticks;
+	}
+
+	stats->agents_count = (uint32_t)(games_count * AGENTS_COUNT);
+	if (stats->agents_count == 0)
+		return;
+
+	stats->mean_lifetime = (float)((double)lifetime_sum / stats->agents_count);
+	stats->p10_lifetime = lifetime_percentile(histogram, stats->agents_count, 10);
+	stats->median_lifetime = lifetime_percentile(histogram, stats->agents_count, 50);
+	stats->p90_lifetime = lifetime_percentile(histogram, stats->agents_count, 90);
+
+	// An agent with the lifetime of `t` was alive for ticks 1..t.
+	uint32_t alive = stats->agents_count;
+	for (uint32_t lifetime = 0, point = 0; point < STATS_ALIVE_CURVE_POINTS; ++point) {
+		for (; lifetime <= point * STATS_ALIVE_CURVE_STEP; ++lifetime)
+			alive -= histogram[lifetime];
+		stats->alive_curve[point] = alive;
+	}
+
+	for (uint32_t lifetime = MAX_LIFETIME + 1; lifetime-- > 0;) {
+		if (histogram[lifetime] > 0) {
+			stats->best_lifetime = lifetime;
+			break;
+		}
+	}
+}
+
+uint32_t lifetime_percentile(const uint32_t *histogram, uint32_t agents_count, uint32_t percent) {
+	uint64_t rank = ((uint64_t)agents_count * percent + 99) / 100;
+	uint64_t seen = 0;
+
+	for (uint32_t lifetime = 0; lifetime <= MAX_LIFETIME; ++lifetime) {
+		seen += histogram[lifetime];
+		if (seen >= rank && seen > 0)
+			return lifetime;
+	}
+
+	return MAX_LIFETIME;
+}
+
+// Gini-Simpson index of every chromosome position, averaged.
+float genome_diversity(const Game *game) {
+	uint8_t counts[STATES_COUNT * ENV_COUNT * AA_COUNT * STATES_COUNT];
+	uint64_t same_pairs = 0;
+
+	for (size_t i = 0; i < GENES_COUNT; ++i) {
+		memset(counts, 0, sizeof(counts));
+
+		// Every agent that already has this gene makes a pair with the new one.
+		for (size_t j = 0; j < AGENTS_COUNT; ++j) {
+			size_t key = gene_key(&game->genomes[j].genes[i]);
+			same_pairs += counts[key];
+			counts[key] += 1;
+		}
+	}
+
+	const uint64_t pairs = (uint64_t)GENES_COUNT * AGENTS_COUNT * (AGENTS_COUNT - 1) / 2;
+	return (float)(1.0 - (double)same_pairs / (double)pairs);
+}
+
+size_t gene_key(const Gene *gene) {
+	size_t key = (size_t)gene->current_state;
+	key = key * ENV_COUNT + (size_t)gene->environment;
+	key = key * AA_COUNT + (size_t)gene->action;
+	return key * STATES_COUNT + (size_t)gene->next_state;
+}
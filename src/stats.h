@@ -0,0 +1,47 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "game.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATS_ALIVE_CURVE_POINTS 64
+#define STATS_ALIVE_CURVE_STEP (MAX_LIFETIME / STATS_ALIVE_CURVE_POINTS)
+
+// Summary of one generation across all islands. Fixed-width fields only,
+// it's shared with other processes as is (see telemetry.h).
+typedef struct {
+	uint64_t generation;
+	uint32_t islands_count;
+	uint32_t agents_count;
+
+	uint32_t best_lifetime;
+	uint32_t p10_lifetime;
+	uint32_t median_lifetime;
+	uint32_t p90_lifetime;
+	float mean_lifetime;
+
+	uint64_t food_eaten;
+	uint64_t attacks;
+	// deaths[DC_ALIVE] counts the agents whose game was ended while they were alive (see play_game).
+	// Their lifetimes are only lower bounds, and so is every lifetime above, once it's not zero.
+	uint32_t deaths[DC_COUNT];
+
+	// How many agents were still alive after every STATS_ALIVE_CURVE_STEP ticks, agents of games that
+	// were ended early count as dead after the tick their game ended on.
+	uint32_t alive_curve[STATS_ALIVE_CURVE_POINTS];
+
+	uint64_t ticks;
+	float ticks_per_second;
+
+	// The chance that two agents of an island carry different genes at the same position of the chromosome,
+	// from 0 (all of them have the same genome) to almost 1 (random genomes), averaged over islands.
+	float diversity;
+} GenerationStats;
+
+// `games` have to be finished, `generation` and `ticks_per_second` are up to the caller.
+void generation_stats_compute(GenerationStats *stats, Game *const games[], size_t games_count);
+float genome_diversity(const Game *game);
+
+#endif // !STATS_H
@@ -0,0 +1,288 @@
+#include "steady_state.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void breed_from_hall_of_fame(const FitnessHeap *heap, Game *game, size_t agent_index);
+void steady_state_replace_dead(SteadyState *state, bool record);
+void steady_state_regrow_food(Game *game);
+void *steady_island_thread(void *arg);
+
+void fitness_heap_push(FitnessHeap *heap, size_t lifetime, const Chromosome *chromosome) {
+	HallOfFameEntry *entries = heap->entries;
+	size_t i = 0;
+
+	if (heap->count < HALL_OF_FAME_CAPACITY) {
+		// Sift the new leaf up.
+		i = heap->count++;
+		while (i > 0) {
+			size_t parent = (i - 1) / 2;
+			if (entries[parent].lifetime <= lifetime)
+				break;
+			entries[i] = entries[parent];
+			i = parent;
+		}
+	} else {
+		// Ties keep the old entry, it got there first.
+		if (lifetime <= entries[0].lifetime)
+			return;
+
+		// Sift the new root down.
+		for (;;) {
+			size_t child = 2 * i + 1;
+			if (child >= heap->count)
+				break;
+			if (child + 1 < heap->count && entries[child + 1].lifetime < entries[child].lifetime)
+				child += 1;
+			if (entries[child].lifetime >= lifetime)
+				break;
+			entries[i] = entries[child];
+			i = child;
+		}
+	}
+
+	entries[i].lifetime = lifetime;
+	memcpy(&entries[i].chromosome, chromosome, sizeof(*chromosome));
+}
+
+size_t fitness_heap_best_lifetime(const FitnessHeap *heap) {
+	size_t best = 0;
+
+	for (size_t i = 0; i < heap->count; ++i) {
+		if (heap->entries[i].lifetime > best)
+			best = heap->entries[i].lifetime;
+	}
+
+	return best;
+}
+
+// The same crossover and mutation as prepare_next_game, with the hall of fame as the mating pool.
+void breed_from_hall_of_fame(const FitnessHeap *heap, Game *game, size_t agent_index) {
+	Chromosome *child = &game->genomes[agent_index];
+	size_t parent_a_index = (size_t)random_int_range(0, (int)heap->count);
+	size_t parent_b_index = (size_t)random_int_range(0, (int)heap->count);
+
+	mate_chromosomes(&heap->entries[parent_a_index].chromosome, &heap->entries[parent_b_index].chromosome, child);
+	mutate_chromosome(child);
+	initialize_basic_agent_properties(game, &game->agents[agent_index], agent_index);
+}
+
+void steady_state_init(SteadyState *state) {
+	state->heap.count = 0;
+	state->tick = 0;
+	state->births = 0;
+	state->filling = 0;
+	state->filling_deaths = 0;
+	state->filling_ticks = 0;
+	state->epoch = NULL;
+	state->epoch_ticks = 0;
+
+	// A saved game may well be a finished one.
+	steady_state_replace_dead(state, false);
+	steady_state_regrow_food(&state->game);
+}
+
+bool steady_state_step(SteadyState *state) {
+	const Game *last_epoch = state->epoch;
+
+	game_step(&state->game);
+	state->tick += 1;
+	state->filling_ticks += 1;
+
+	steady_state_replace_dead(state, true);
+	steady_state_regrow_food(&state->game);
+
+	return state->epoch != last_epoch;
+}
+
+// Every dead agent goes into the hall of fame first, so even the very first death has a parent to breed from.
+void steady_state_replace_dead(SteadyState *state, bool record) {
+	Game *game = &state->game;
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i) {
+		const Agent *agent = &game->agents[i];
+		if (agent->health > 0)
+			continue;
+
+		fitness_heap_push(&state->heap, agent->lifetime, &game->genomes[i]);
+
+		if (record) {
+			Game *epoch = &state->epochs[state->filling];
+			memcpy(&epoch->agents[state->filling_deaths], agent, sizeof(*agent));
+			memcpy(&epoch->genomes[state->filling_deaths], &game->genomes[i], sizeof(game->genomes[i]));
+			state->filling_deaths += 1;
+
+			if (state->filling_deaths == AGENTS_COUNT) {
+				state->epoch = epoch;
+				state->epoch_ticks = state->filling_ticks;
+				state->filling = 1 - state->filling;
+				state->filling_deaths = 0;
+				state->filling_ticks = 0;
+			}
+		}
+
+		breed_from_hall_of_fame(&state->heap, game, i);
+		state->births += 1;
+	}
+}
+
+// Eaten food grows back on a random empty cell, the board never runs out of it.
+void steady_state_regrow_food(Game *game) {
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		Food *food = &game->food[i];
+		if (food->quantity > 0)
+			continue;
+
+		food->pos = random_empty_position(game);
+		food->quantity = 1;
+	}
+}
+
+void steady_state_export(const SteadyState *state, Game *out) {
+	// Agents still alive have earned at least their current lifetime.
+	FitnessHeap heap = state->heap;
+	for (size_t i = 0; i < AGENTS_COUNT; ++i)
+		fitness_heap_push(&heap, state->game.agents[i].lifetime, &state->game.genomes[i]);
+
+	memset(out, 0, sizeof(*out));
+	memcpy(out->walls, state->game.walls, WALLS_COUNT * sizeof(Wall));
+	memcpy(out->food, state->game.food, FOOD_COUNT * sizeof(Food));
+	for (size_t i = 0; i < FOOD_COUNT; ++i)
+		out->food[i].quantity = 1;
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i)
+		breed_from_hall_of_fame(&heap, out, i);
+}
+
+SteadyStateRun *steady_state_start(const Game *seed_game, size_t islands_count, unsigned int seed) {
+	SteadyStateRun *run = calloc(1, sizeof(*run));
+	SteadyIsland *islands = calloc(islands_count, sizeof(*islands));
+
+	if (run == NULL || islands == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate %zu steady-state islands.\n", islands_count);
+		free(run);
+		free(islands);
+		return NULL;
+	}
+
+	atomic_init(&run->stop, false);
+	pthread_mutex_init(&run->mutex, NULL);
+	pthread_cond_init(&run->changed, NULL);
+	run->islands = islands;
+
+	seed_random(seed);
+	for (size_t i = 0; i < islands_count; ++i) {
+		SteadyIsland *island = &islands[i];
+		island->run = run;
+		island->seed = seed + (unsigned int)i + 1;
+
+		if (i == 0 && seed_game != NULL) {
+			memcpy(&island->state.game, seed_game, sizeof(*seed_game));
+		} else {
+			initialize_game(&island->state.game);
+		}
+	}
+
+	for (size_t i = 0; i < islands_count; ++i) {
+		if (pthread_create(&islands[i].thread, NULL, steady_island_thread, &islands[i]) != 0) {
+			fprintf(stderr, "ERROR: Couldn't start the steady-state thread for island %zu.\n", i);
+			break;
+		}
+		run->islands_count += 1;
+	}
+
+	if (run->islands_count == 0) {
+		pthread_cond_destroy(&run->changed);
+		pthread_mutex_destroy(&run->mutex);
+		free(islands);
+		free(run);
+		return NULL;
+	}
+
+	return run;
+}
+
+void steady_state_stop(SteadyStateRun *run, Game *best) {
+	if (run == NULL)
+		return;
+
+	pthread_mutex_lock(&run->mutex);
+	atomic_store(&run->stop, true);
+	pthread_cond_broadcast(&run->changed);
+	pthread_mutex_unlock(&run->mutex);
+
+	for (size_t i = 0; i < run->islands_count; ++i)
+		pthread_join(run->islands[i].thread, NULL);
+
+	if (best != NULL) {
+		size_t best_island = 0;
+		size_t best_lifetime = 0;
+
+		for (size_t i = 0; i < run->islands_count; ++i) {
+			size_t lifetime = fitness_heap_best_lifetime(&run->islands[i].state.heap);
+			if (lifetime > best_lifetime) {
+				best_island = i;
+				best_lifetime = lifetime;
+			}
+		}
+
+		steady_state_export(&run->islands[best_island].state, best);
+	}
+
+	pthread_cond_destroy(&run->changed);
+	pthread_mutex_destroy(&run->mutex);
+	free(run->islands);
+	free(run);
+}
+
+SteadyIsland *steady_state_wait_epoch(SteadyStateRun *run) {
+	SteadyIsland *result = NULL;
+
+	pthread_mutex_lock(&run->mutex);
+	while (result == NULL) {
+		for (size_t i = 0; i < run->islands_count; ++i) {
+			size_t index = (run->next_island + i) % run->islands_count;
+			if (run->islands[index].epoch_ready) {
+				result = &run->islands[index];
+				run->next_island = (index + 1) % run->islands_count;
+				break;
+			}
+		}
+
+		if (result == NULL)
+			pthread_cond_wait(&run->changed, &run->mutex);
+	}
+	pthread_mutex_unlock(&run->mutex);
+
+	return result;
+}
+
+void steady_state_release(SteadyStateRun *run, SteadyIsland *island) {
+	pthread_mutex_lock(&run->mutex);
+	island->epoch_ready = false;
+	pthread_cond_broadcast(&run->changed);
+	pthread_mutex_unlock(&run->mutex);
+}
+
+void *steady_island_thread(void *arg) {
+	SteadyIsland *island = arg;
+	SteadyStateRun *run = island->run;
+
+	seed_random(island->seed);
+	steady_state_init(&island->state);
+
+	while (!atomic_load_explicit(&run->stop, memory_order_relaxed)) {
+		if (!steady_state_step(&island->state))
+			continue;
+
+		pthread_mutex_lock(&run->mutex);
+		island->epoch_ready = true;
+		pthread_cond_broadcast(&run->changed);
+		while (island->epoch_ready && !atomic_load(&run->stop))
+			pthread_cond_wait(&run->changed, &run->mutex);
+		pthread_mutex_unlock(&run->mutex);
+	}
+
+	return NULL;
+}
@@ -0,0 +1,88 @@
+#ifndef STEADY_STATE_H
+#define STEADY_STATE_H
+
+#include "game.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define HALL_OF_FAME_CAPACITY MATING_SELECTION_POOL
+
+typedef struct {
+	size_t lifetime;
+	Chromosome chromosome;
+} HallOfFameEntry;
+
+// The best agents that ever died, kept as a min-heap on lifetime: the root is the weakest
+// of them and the first one to be pushed out by somebody better.
+typedef struct {
+	size_t count;
+	HallOfFameEntry entries[HALL_OF_FAME_CAPACITY];
+} FitnessHeap;
+
+// Evolution without generations: the game never restarts, every agent that dies is replaced
+// right away by a child of two hall-of-fame agents, and eaten food grows back somewhere else.
+typedef struct {
+	Game game;
+	FitnessHeap heap;
+	size_t tick;
+	size_t births;
+
+	// An epoch is the next AGENTS_COUNT agents to die, it stands in for a generation in stats and metrics.
+	// Epochs are shaped like finished games and filled in turns, so that a tick with many deaths
+	// can start the next one while the last one is still being read.
+	Game epochs[2];
+	size_t filling;
+	size_t filling_deaths;
+	size_t filling_ticks;
+	const Game *epoch; // the last complete epoch, NULL before the first one
+	size_t epoch_ticks;
+} SteadyState;
+
+void fitness_heap_push(FitnessHeap *heap, size_t lifetime, const Chromosome *chromosome);
+size_t fitness_heap_best_lifetime(const FitnessHeap *heap);
+
+// Takes over whatever is in `state->game`, agents that are already dead are replaced straight away.
+void steady_state_init(SteadyState *state);
+
+// One tick of the game plus the replacement of everybody who died in it.
+// Returns true when this tick completed an epoch, it stays in `epoch` until the one after it completes.
+bool steady_state_step(SteadyState *state);
+
+// A brand new game bred from the hall of fame and the agents still alive,
+// the way to continue with the generational trainer.
+void steady_state_export(const SteadyState *state, Game *out);
+
+struct SteadyStateRun;
+
+typedef struct {
+	struct SteadyStateRun *run;
+	pthread_t thread;
+	unsigned int seed;
+	bool epoch_ready; // guarded by the run's mutex
+	SteadyState state;
+} SteadyIsland;
+
+// Every island steps its own game on its own thread, nothing ever waits for the other islands.
+// An island only stops after completing an epoch, until the reader is done with it.
+typedef struct SteadyStateRun {
+	atomic_bool stop;
+	pthread_mutex_t mutex;
+	pthread_cond_t changed;
+	size_t next_island; // where the search for a complete epoch starts, so that no island is left waiting
+	size_t islands_count;
+	SteadyIsland *islands;
+} SteadyStateRun;
+
+// The first island continues `seed_game`, the rest start from scratch.
+SteadyStateRun *steady_state_start(const Game *seed_game, size_t islands_count, unsigned int seed);
+// Stops every island, then breeds `best` (unless it's NULL) from the island with the longest-lived hall of fame.
+void steady_state_stop(SteadyStateRun *run, Game *best);
+
+// Blocks until an island completes an epoch and returns it, the island waits for steady_state_release.
+SteadyIsland *steady_state_wait_epoch(SteadyStateRun *run);
+void steady_state_release(SteadyStateRun *run, SteadyIsland *island);
+
+#endif // !STEADY_STATE_H
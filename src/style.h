@@ -5,5 +5,11 @@
 #define AGENT_COLOR 0xFFFD7F02
 #define WALL_COLOR 0xFF5680AD
 #define FOOD_COLOR 0x6694FC02
+#define HIGHLIGHT_COLOR 0xFFFFFFFF
+#define BOARD_OUTLINE_COLOR 0xFF3A4047
+#define OVERLAY_BACKGROUND_COLOR 0xC0181B1F
+#define OVERLAY_TEXT_COLOR 0xFFD0D0D0
+#define FITNESS_BEST_COLOR 0xFFFD7F02
+#define FITNESS_MEAN_COLOR 0xFF5680AD
 
 #endif // !STYLE_H
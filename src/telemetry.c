@@ -0,0 +1,178 @@
+#include "telemetry.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TELEMETRY_MAGIC 0x4D4C5447u // "GTLM"
+
+static_assert((TELEMETRY_CAPACITY & (TELEMETRY_CAPACITY - 1)) == 0, "Telemetry capacity has to be a power of two.");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared-memory atomics have to be lock-free to work across processes.");
+
+pid_t telemetry_segment_writer(const char *name);
+
+// Pid of the live trainer that writes into the segment, 0 when nobody does anymore or it isn't a telemetry segment.
+pid_t telemetry_segment_writer(const char *name) {
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return 0;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(TelemetrySegment)) {
+		close(fd);
+		return 0;
+	}
+
+	void *memory = mmap(NULL, sizeof(TelemetrySegment), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (memory == MAP_FAILED)
+		return 0;
+
+	const TelemetrySegment *segment = memory;
+	pid_t pid = segment->magic == TELEMETRY_MAGIC ? (pid_t)segment->writer_pid : 0;
+	munmap(memory, sizeof(TelemetrySegment));
+
+	return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM) ? pid : 0;
+}
+
+bool telemetry_create(Telemetry *telemetry, const char *name) {
+	memset(telemetry, 0, sizeof(*telemetry));
+	snprintf(telemetry->name, sizeof(telemetry->name), "%s", name);
+
+	// Only a segment left behind by a crashed trainer is replaced, a running one keeps its monitors.
+	int fd = shm_open(telemetry->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0 && errno == EEXIST) {
+		pid_t writer = telemetry_segment_writer(telemetry->name);
+		if (writer != 0) {
+			fprintf(stderr,
+				"ERROR: The telemetry segment `%s` belongs to the trainer with pid %d, pick another name with --telemetry.\n",
+				name,
+				(int)writer);
+			return false;
+		}
+
+		shm_unlink(telemetry->name);
+		fd = shm_open(telemetry->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	}
+	if (fd < 0) {
+		fprintf(stderr, "ERROR: Couldn't create the telemetry segment `%s`: %s.\n", name, strerror(errno));
+		return false;
+	}
+
+	if (ftruncate(fd, sizeof(TelemetrySegment)) != 0) {
+		fprintf(stderr, "ERROR: Couldn't resize the telemetry segment `%s`: %s.\n", name, strerror(errno));
+		close(fd);
+		shm_unlink(telemetry->name);
+		return false;
+	}
+
+	void *memory = mmap(NULL, sizeof(TelemetrySegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (memory == MAP_FAILED) {
+		fprintf(stderr, "ERROR: Couldn't map the telemetry segment `%s`: %s.\n", name, strerror(errno));
+		shm_unlink(telemetry->name);
+		return false;
+	}
+
+	// ftruncate gives zeroes, so every sequence already says "nothing here".
+	TelemetrySegment *segment = memory;
+	segment->version = TELEMETRY_VERSION;
+	segment->capacity = TELEMETRY_CAPACITY;
+	segment->writer_pid = (int32_t)getpid();
+	atomic_init(&segment->published, 0);
+	atomic_thread_fence(memory_order_release);
+	segment->magic = TELEMETRY_MAGIC;
+
+	telemetry->owner = true;
+	telemetry->segment = segment;
+	return true;
+}
+
+void telemetry_publish(Telemetry *telemetry, const GenerationStats *stats) {
+	TelemetrySegment *segment = telemetry->segment;
+	if (segment == NULL)
+		return;
+
+	uint64_t record = atomic_load_explicit(&segment->published, memory_order_relaxed);
+	TelemetrySlot *slot = &segment->slots[record & (TELEMETRY_CAPACITY - 1)];
+
+	atomic_store_explicit(&slot->sequence, 2 * record + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	memcpy(&slot->stats, stats, sizeof(*stats));
+	atomic_store_explicit(&slot->sequence, 2 * record + 2, memory_order_release);
+	atomic_store_explicit(&segment->published, record + 1, memory_order_release);
+}
+
+bool telemetry_attach(Telemetry *telemetry, const char *name) {
+	memset(telemetry, 0, sizeof(*telemetry));
+	snprintf(telemetry->name, sizeof(telemetry->name), "%s", name);
+
+	int fd = shm_open(telemetry->name, O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(TelemetrySegment)) {
+		close(fd);
+		return false;
+	}
+
+	// Read-only on purpose: whatever a monitor does, it can't disturb the trainer.
+	void *memory = mmap(NULL, sizeof(TelemetrySegment), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (memory == MAP_FAILED)
+		return false;
+
+	TelemetrySegment *segment = memory;
+	if (segment->magic != TELEMETRY_MAGIC || segment->version != TELEMETRY_VERSION ||
+	    segment->capacity != TELEMETRY_CAPACITY) {
+		munmap(memory, sizeof(TelemetrySegment));
+		return false;
+	}
+
+	telemetry->segment = segment;
+	return true;
+}
+
+// The segment outlives a trainer that was killed, this is how monitors notice.
+bool telemetry_writer_is_alive(const Telemetry *telemetry) {
+	pid_t pid = (pid_t)telemetry->segment->writer_pid;
+	return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+uint64_t telemetry_published(const Telemetry *telemetry) {
+	return atomic_load_explicit(&telemetry->segment->published, memory_order_acquire);
+}
+
+TelemetryReadResult telemetry_read(const Telemetry *telemetry, uint64_t record, GenerationStats *out) {
+	TelemetrySlot *slot = &telemetry->segment->slots[record & (TELEMETRY_CAPACITY - 1)];
+	uint64_t expected = 2 * record + 2;
+
+	uint64_t before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+	if (before < expected)
+		return TR_NOT_YET;
+	if (before > expected)
+		return TR_LOST;
+
+	memcpy(out, &slot->stats, sizeof(*out));
+	atomic_thread_fence(memory_order_acquire);
+
+	uint64_t after = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+	return after == expected ? TR_OK : TR_LOST;
+}
+
+void telemetry_close(Telemetry *telemetry) {
+	if (telemetry->segment != NULL)
+		munmap(telemetry->segment, sizeof(TelemetrySegment));
+	if (telemetry->owner)
+		shm_unlink(telemetry->name);
+
+	telemetry->segment = NULL;
+	telemetry->owner = false;
+}
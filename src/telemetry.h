@@ -0,0 +1,64 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "stats.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define TELEMETRY_DEFAULT_NAME "/gp_trainer_telemetry"
+#define TELEMETRY_CAPACITY 256 // has to be a power of two
+#define TELEMETRY_VERSION 2
+
+/*
+ * Ring of GenerationStats in a named POSIX shared-memory segment.
+ *
+ * The trainer is the only writer and never waits for anybody: every slot is a seqlock,
+ * its sequence is 2 * record + 1 while the record is being written and 2 * record + 2
+ * once it's there. Monitors map the segment read-only and copy a record out, the copy is
+ * only valid when the sequence is the expected one before and after it. They can attach
+ * and detach at any time, a slow monitor just misses the records that were overwritten.
+ */
+
+typedef struct {
+	atomic_uint_least64_t sequence;
+	GenerationStats stats;
+} TelemetrySlot;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t capacity;
+	int32_t writer_pid;
+	atomic_uint_least64_t published; // records written so far
+	TelemetrySlot slots[TELEMETRY_CAPACITY];
+} TelemetrySegment;
+
+typedef struct {
+	char name[64];
+	bool owner;
+	TelemetrySegment *segment;
+} Telemetry;
+
+typedef enum {
+	TR_OK = 0,
+	TR_NOT_YET, // the record isn't published yet
+	TR_LOST, // the record was already overwritten
+} TelemetryReadResult;
+
+// Writer side, the segment is removed again by telemetry_close. A segment of a trainer that is still
+// running isn't taken over, one left behind by a dead trainer is replaced.
+bool telemetry_create(Telemetry *telemetry, const char *name);
+void telemetry_publish(Telemetry *telemetry, const GenerationStats *stats);
+
+// Reader side.
+bool telemetry_attach(Telemetry *telemetry, const char *name);
+bool telemetry_writer_is_alive(const Telemetry *telemetry);
+uint64_t telemetry_published(const Telemetry *telemetry);
+TelemetryReadResult telemetry_read(const Telemetry *telemetry, uint64_t record, GenerationStats *out);
+
+void telemetry_close(Telemetry *telemetry);
+
+#endif // !TELEMETRY_H
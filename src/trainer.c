@@ -1,35 +1,559 @@
+#include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include "frame_export.h"
 #include "game.h"
+#include "metrics.h"
+#include "stats.h"
+#include "steady_state.h"
+#include "telemetry.h"
+#include "training_budget.h"
+#include "verify.h"
+#include "worker_pool.h"
 
 #define TRAINING_THRESHHOLD 2048
+#define TRAINER_MAX_ISLANDS 256
+
+typedef struct {
+	size_t workers_count;
+	size_t islands_count;
+	const char *telemetry_name;
+	const char *metrics_prefix;
+	bool metrics_csv;
+	bool verify;
+	bool steady_state;
+	bool has_seed;
+	size_t seed;
+	size_t generations; // 0 means the default of the mode, epochs in the steady state
+	StoppingCriteria stopping;
+	bool adaptive_ticks;
+	const char *frames_directory;
+	size_t frame_every;
+	FrameFormat frame_format;
+} TrainerOptions;
+
+typedef struct {
+	int current_game;
+	Game games[2];
+} TrainerIsland;
+
+// The island that's filmed, played on its own thread while the pool evaluates the others.
+typedef struct {
+	FrameExporter *frames;
+	Game *game;
+	uint64_t generation;
+	size_t survivors;
+	size_t every;
+	uint64_t *ticks;
+} FilmedGame;
+
+bool parse_options(int argc, char *argv[], TrainerOptions *options);
+bool parse_count(const char *arg, unsigned long max, size_t *out);
+bool parse_fraction(const char *arg, float *out);
+void print_usage(const char *program);
+void print_generation_summary(TrainerIsland *islands, size_t islands_count);
+size_t find_best_island(TrainerIsland *islands, size_t islands_count);
+double seconds_since(const struct timespec *start);
+int train_steady_state(const TrainerOptions *options, unsigned int seed, size_t epochs);
+void play_filmed_game(FrameExporter *frames, Game *game, uint64_t generation, size_t survivors, size_t every, uint64_t *ticks);
+void *filmed_game_thread(void *arg);
 
 int main(int argc, char *argv[]) {
-	(void)argc;
-	(void)argv;
+	TrainerOptions options = {
+		0, 1, TELEMETRY_DEFAULT_NAME, NULL, false, false, false, false, 0, 0, { 0, 0, 0, 0.f }, false, NULL, 1, FF_QOI
+	};
+	if (!parse_options(argc, argv, &options)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	unsigned int seed = options.has_seed ? (unsigned int)options.seed : (unsigned int)time(0);
 
-	srand((unsigned int)time(0));
+	if (options.verify) {
+		size_t generations = options.generations > 0 ? options.generations : VERIFY_DEFAULT_GENERATIONS;
+		return verify_engines(seed, generations) && verify_pool(seed, generations) ? 0 : 1;
+	}
+
+	size_t generations = options.generations > 0 ? options.generations : TRAINING_THRESHHOLD;
+	if (options.steady_state)
+		return train_steady_state(&options, seed, generations);
+
+	seed_random(seed);
 
-	const char *filepath = "./output/game_state.bin";
-	Game games[2] = { 0 };
-	int current_game = 0;
-	load_game_state(filepath, &games[current_game]);
+	TrainerIsland *islands = calloc(options.islands_count, sizeof(*islands));
+	Game **evaluated = calloc(options.islands_count, sizeof(*evaluated));
+	if (islands == NULL || evaluated == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate %zu islands.\n", options.islands_count);
+		free(islands);
+		free(evaluated);
+		return 1;
+	}
+
+	// The first island continues the saved game, the rest are independent populations.
+	const char *filepath = GAME_STATE_FILEPATH;
+	if (!load_game_state(filepath, &islands[0].games[0])) {
+		fprintf(stdout, "INFO: The first island starts from a new game.\n");
+		initialize_game(&islands[0].games[0]);
+	}
+	for (size_t i = 1; i < options.islands_count; ++i)
+		initialize_game(&islands[i].games[0]);
 
-	for (size_t i = 0; i < TRAINING_THRESHHOLD; ++i) {
+	WorkerPool pool;
+	// Parents are picked uniformly from the MATING_SELECTION_POOL longest-lived agents. Once that few are alive,
+	// they make up the pool however long they go on to live: survivors rank above the agents that died with
+	// the same lifetime. The pool only differs when a survivor is killed in the next tick before it ages and
+	// ties with those agents at the edge of the pool (2 games out of 900 measured). The order inside the pool
+	// does change, so the same parents are drawn with the same odds, just not in the same pairs.
+	size_t survivors = options.adaptive_ticks ? MATING_SELECTION_POOL : 0;
+	if (options.adaptive_ticks)
+		fprintf(stdout,
+			"INFO: Games end at %d agents alive, their lifetimes in the statistics and metrics are lower bounds.\n",
+			MATING_SELECTION_POOL);
+	if (!worker_pool_start(&pool, options.workers_count, survivors)) {
+		free(islands);
+		free(evaluated);
+		return 1;
+	}
+
+	// Training goes on without it, monitors just won't find anything to attach to.
+	Telemetry telemetry;
+	if (!telemetry_create(&telemetry, options.telemetry_name))
+		fprintf(stderr, "WARNING: Training without telemetry.\n");
+
+	MetricsWriter *metrics = NULL;
+	if (options.metrics_prefix != NULL) {
+		metrics = metrics_open(options.metrics_prefix, options.metrics_csv);
+		if (metrics == NULL) {
+			worker_pool_stop(&pool);
+			telemetry_close(&telemetry);
+			free(islands);
+			free(evaluated);
+			return 1;
+		}
+	}
+
+	// Frames are taken from the first island, played in this process next to the pool.
+	FrameExporter *frames = NULL;
+	uint64_t filmed_ticks = 0;
+	if (options.frames_directory != NULL) {
+		frames = frame_exporter_start(options.frames_directory, options.frame_format, RASTER_DEFAULT_CELL_SIZE);
+		if (frames == NULL) {
+			worker_pool_stop(&pool);
+			telemetry_close(&telemetry);
+			if (metrics != NULL)
+				metrics_close(metrics);
+			free(islands);
+			free(evaluated);
+			return 1;
+		}
+	}
+
+	TrainingBudget budget;
+	training_budget_start(&budget, &options.stopping);
+
+	for (size_t i = 0; i < generations; ++i) {
 		fprintf(stdout, "Generation `%zu`.\n", i + 1);
 
-		while (!is_everyone_dead(&games[current_game]))
-			game_step(&games[current_game]);
+		for (size_t j = 0; j < options.islands_count; ++j)
+			evaluated[j] = &islands[j].games[islands[j].current_game];
+
+		struct timespec evaluation_start;
+		clock_gettime(CLOCK_MONOTONIC, &evaluation_start);
+
+		if (frames != NULL) {
+			// Filming doesn't hold up the pool: a generation takes as long as the slower of the two.
+			FilmedGame filmed = { frames, evaluated[0], i + 1, survivors, options.frame_every, &filmed_ticks };
+			pthread_t filming;
+			bool threaded = pthread_create(&filming, NULL, filmed_game_thread, &filmed) == 0;
+			if (!threaded)
+				filmed_game_thread(&filmed);
+
+			bool evaluated_rest =
+				options.islands_count == 1 || worker_pool_evaluate(&pool, evaluated + 1, options.islands_count - 1);
+			if (threaded)
+				pthread_join(filming, NULL);
+			if (!evaluated_rest)
+				break;
+		} else if (!worker_pool_evaluate(&pool, evaluated, options.islands_count)) {
+			break;
+		}
+
+		GenerationStats stats;
+		double elapsed = seconds_since(&evaluation_start);
+		generation_stats_compute(&stats, evaluated, options.islands_count);
+		stats.generation = i + 1;
+		stats.ticks_per_second = elapsed > 0 ? (float)((double)stats.ticks / elapsed) : 0.f;
+		telemetry_publish(&telemetry, &stats);
+
+		if (metrics != NULL) {
+			metrics_write_generation(metrics, &stats);
+			for (size_t j = 0; j < options.islands_count; ++j)
+				metrics_write_agents(metrics, stats.generation, j, evaluated[j]);
+		}
+
+		// Only the games evaluated here have the history worth printing.
+		if (options.workers_count == 0 && options.islands_count == 1)
+			print_the_state_of_oldest_agent(evaluated[0]);
+		else
+			print_generation_summary(islands, options.islands_count);
+
+		// Breed even the last generation, the saved game is the one that would have come next.
+		StopReason reason = training_budget_check(&budget, &stats);
+
+		for (size_t j = 0; j < options.islands_count; ++j) {
+			TrainerIsland *island = &islands[j];
+			int next = 1 - island->current_game;
+			prepare_next_game(&island->games[island->current_game], &island->games[next]);
+			island->current_game = next;
+		}
+
+		if (reason != SR_NONE) {
+			fprintf(stdout,
+				"INFO: Stopping after generation %zu, %s (best lifetime %u in generation %llu).\n",
+				i + 1,
+				stop_reason_as_cstr(reason),
+				budget.best_lifetime,
+				(unsigned long long)budget.best_generation);
+			break;
+		}
+	}
+
+	// Lost metrics or frames don't stop the game from being saved, but the run didn't fully succeed.
+	bool complete = true;
+	worker_pool_stop(&pool);
+	telemetry_close(&telemetry);
+	if (metrics != NULL)
+		complete = metrics_close(metrics) && complete;
+	if (frames != NULL)
+		complete = frame_exporter_stop(frames) && complete;
+
+	// The island whose last generation lived the longest is the one worth continuing.
+	size_t best_island = find_best_island(islands, options.islands_count);
+	dump_game_state(filepath, &islands[best_island].games[islands[best_island].current_game]);
+
+	free(islands);
+	free(evaluated);
+	return complete ? 0 : 1;
+}
+
+bool parse_options(int argc, char *argv[], TrainerOptions *options) {
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--metrics-csv") == 0) {
+			options->metrics_csv = true;
+			continue;
+		}
+		if (strcmp(argv[i], "--verify") == 0) {
+			options->verify = true;
+			continue;
+		}
+		if (strcmp(argv[i], "--steady-state") == 0) {
+			options->steady_state = true;
+			continue;
+		}
+		if (strcmp(argv[i], "--adaptive-ticks") == 0) {
+			options->adaptive_ticks = true;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+			return false;
+
+		if (strcmp(argv[i], "--workers") == 0) {
+			if (!parse_count(argv[++i], WORKER_POOL_MAX_WORKERS, &options->workers_count))
+				return false;
+		} else if (strcmp(argv[i], "--telemetry") == 0) {
+			options->telemetry_name = argv[++i];
+		} else if (strcmp(argv[i], "--metrics") == 0) {
+			options->metrics_prefix = argv[++i];
+		} else if (strcmp(argv[i], "--seed") == 0) {
+			if (!parse_count(argv[++i], UINT_MAX, &options->seed))
+				return false;
+			options->has_seed = true;
+		} else if (strcmp(argv[i], "--generations") == 0) {
+			if (!parse_count(argv[++i], ULONG_MAX, &options->generations))
+				return false;
+		} else if (strcmp(argv[i], "--patience") == 0) {
+			if (!parse_count(argv[++i], ULONG_MAX, &options->stopping.patience))
+				return false;
+		} else if (strcmp(argv[i], "--target-lifetime") == 0) {
+			if (!parse_count(argv[++i], MAX_LIFETIME, &options->stopping.target_lifetime))
+				return false;
+		} else if (strcmp(argv[i], "--time-budget") == 0) {
+			if (!parse_count(argv[++i], ULONG_MAX, &options->stopping.time_budget))
+				return false;
+		} else if (strcmp(argv[i], "--diversity-floor") == 0) {
+			if (!parse_fraction(argv[++i], &options->stopping.diversity_floor))
+				return false;
+		} else if (strcmp(argv[i], "--frames") == 0) {
+			options->frames_directory = argv[++i];
+		} else if (strcmp(argv[i], "--frame-every") == 0) {
+			if (!parse_count(argv[++i], ULONG_MAX, &options->frame_every) || options->frame_every == 0)
+				return false;
+		} else if (strcmp(argv[i], "--frame-format") == 0) {
+			if (!frame_format_parse(argv[++i], &options->frame_format))
+				return false;
+		} else if (strcmp(argv[i], "--islands") == 0) {
+			if (!parse_count(argv[++i], TRAINER_MAX_ISLANDS, &options->islands_count) ||
+			    options->islands_count == 0)
+				return false;
+		} else {
+			return false;
+		}
+	}
+
+	// Steady-state islands are threads of this process, there are no games to hand out to workers,
+	// no games that end and no game to film either.
+	if (options->steady_state && (options->workers_count > 0 || options->adaptive_ticks || options->frames_directory != NULL))
+		return false;
+
+	// Lifetimes of games cut short stop at the tick they were cut on, nobody could ever beat that tick.
+	if (options->adaptive_ticks && (options->stopping.patience > 0 || options->stopping.target_lifetime > 0))
+		return false;
+
+	// CSV goes next to the binary tables, there is nothing to put it next to without them.
+	return options->metrics_prefix != NULL || !options->metrics_csv;
+}
+
+bool parse_count(const char *arg, unsigned long max, size_t *out) {
+	char *end = NULL;
+	unsigned long value = strtoul(arg, &end, 10);
+
+	if (end == arg || *end != '\0' || value > max)
+		return false;
+
+	*out = (size_t)value;
+	return true;
+}
+
+bool parse_fraction(const char *arg, float *out) {
+	char *end = NULL;
+	float value = strtof(arg, &end);
+
+	if (end == arg || *end != '\0' || !(value >= 0.f && value <= 1.f))
+		return false;
+
+	*out = value;
+	return true;
+}
+
+void print_usage(const char *program) {
+	fprintf(stderr,
+		"Usage: %s [--workers N] [--islands M] [--telemetry NAME] [--metrics PREFIX [--metrics-csv]]\n"
+		"          [--seed S] [--generations G] [--patience N] [--target-lifetime L] [--time-budget SECONDS]\n"
+		"          [--diversity-floor D] [--adaptive-ticks] [--frames DIR [--frame-every N] [--frame-format F]]\n"
+		"          [--steady-state] [--verify]\n"
+		"\t--workers N       evaluate generations in N worker processes (0..%d, 0 means in this process)\n"
+		"\t--islands M       evolve M independent populations (1..%d), the first one continues %s\n"
+		"\t--telemetry NAME  shared-memory segment the monitor attaches to (%s by default)\n"
+		"\t--metrics PREFIX  stream per-generation and per-agent metrics into PREFIX.generations.bin and PREFIX.agents.bin\n"
+		"\t--metrics-csv     write the metrics as CSV too\n"
+		"\t--seed S          seed of the random generator (the current time by default)\n"
+		"\t--generations G   how many generations to run (%d to train, %d to verify by default)\n"
+		"\t--patience N      stop after N generations in a row without a new best lifetime\n"
+		"\t--target-lifetime L\n"
+		"\t                  stop once an agent lives L ticks (up to %d)\n"
+		"\t--time-budget SECONDS\n"
+		"\t                  stop after the first generation that ends past SECONDS of training\n"
+		"\t--diversity-floor D\n"
+		"\t                  stop once the diversity of the genomes (0..1, see stats.h) falls below D\n"
+		"\t--adaptive-ticks  end a game once only %d agents are alive, they are the mating pool anyway\n"
+		"\t                  (not with --patience or --target-lifetime, lifetimes stop where games are ended)\n"
+		"\t--frames DIR      draw the first island's games into DIR without a display, one image per frame\n"
+		"\t--frame-every N   take a frame every N ticks (1 by default)\n"
+		"\t--frame-format F  ppm or qoi (the default)\n"
+		"\t--steady-state    replace every agent as soon as it dies instead of breeding generations,\n"
+		"\t                  every island on its own thread (not with --workers, --adaptive-ticks or --frames);\n"
+		"\t                  G counts epochs of %d deaths on one island then\n"
+		"\t--verify          run the optimized engine next to the reference one from a new game and\n"
+		"\t                  stop at the first tick after which they disagree, then check that games\n"
+		"\t                  stopped early (--adaptive-ticks) breed the same through %d workers\n",
+		program,
+		WORKER_POOL_MAX_WORKERS,
+		TRAINER_MAX_ISLANDS,
+		GAME_STATE_FILEPATH,
+		TELEMETRY_DEFAULT_NAME,
+		TRAINING_THRESHHOLD,
+		VERIFY_DEFAULT_GENERATIONS,
+		MAX_LIFETIME,
+		MATING_SELECTION_POOL,
+		AGENTS_COUNT,
+		VERIFY_POOL_WORKERS);
+}
+
+// Called between evaluation and breeding, while `current_game` still holds the finished games.
+void print_generation_summary(TrainerIsland *islands, size_t islands_count) {
+	for (size_t i = 0; i < islands_count; ++i) {
+		const Game *game = &islands[i].games[islands[i].current_game];
+		size_t best_lifetime = 0;
+		size_t lifetime_sum = 0;
+
+		for (size_t j = 0; j < AGENTS_COUNT; ++j) {
+			lifetime_sum += game->agents[j].lifetime;
+			if (game->agents[j].lifetime > best_lifetime)
+				best_lifetime = game->agents[j].lifetime;
+		}
+
+		fprintf(stdout,
+			"\tisland: %3zu    best lifetime: %3zu    mean lifetime: %6.2f\n",
+			i,
+			best_lifetime,
+			(double)lifetime_sum / AGENTS_COUNT);
+	}
+}
+
+// The island whose finished game has the longest-lived agent.
+size_t find_best_island(TrainerIsland *islands, size_t islands_count) {
+	size_t best_island = 0;
+	size_t best_lifetime = 0;
+
+	for (size_t i = 0; i < islands_count; ++i) {
+		const Game *finished = &islands[i].games[1 - islands[i].current_game];
+
+		for (size_t j = 0; j < AGENTS_COUNT; ++j) {
+			if (finished->agents[j].lifetime > best_lifetime) {
+				best_island = i;
+				best_lifetime = finished->agents[j].lifetime;
+			}
+		}
+	}
+
+	return best_island;
+}
+
+// The same as play_game, with a frame before every `every`-th tick counted over the whole run.
+void play_filmed_game(FrameExporter *frames, Game *game, uint64_t generation, size_t survivors, size_t every, uint64_t *ticks) {
+	DecisionTable table;
+	const DecisionTable *decisions = decision_table_build(&table, game);
+
+	for (uint64_t tick = 0; count_alive_agents(game) > survivors; ++tick) {
+		if (*ticks % every == 0)
+			frame_exporter_submit(frames, game, generation, tick);
+
+		game_step_with_table(game, decisions);
+		*ticks += 1;
+	}
+}
+
+void *filmed_game_thread(void *arg) {
+	FilmedGame *filmed = arg;
 
-		print_the_state_of_oldest_agent(&games[current_game]);
+	play_filmed_game(filmed->frames, filmed->game, filmed->generation, filmed->survivors, filmed->every, filmed->ticks);
+	return NULL;
+}
+
+double seconds_since(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Same outputs as the generational loop in main, with an epoch of one island in place of a generation of all of them.
+int train_steady_state(const TrainerOptions *options, unsigned int seed, size_t epochs) {
+	Game *game = calloc(1, sizeof(*game));
+	if (game == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate the game to continue.\n");
+		return 1;
+	}
 
-		int next = 1 - current_game;
-		prepare_next_game(&games[current_game], &games[next]);
-		current_game = next;
+	const char *filepath = GAME_STATE_FILEPATH;
+	if (!load_game_state(filepath, game)) {
+		fprintf(stdout, "INFO: The first island starts from a new game.\n");
+		seed_random(seed);
+		initialize_game(game);
 	}
 
-	dump_game_state(filepath, &games[current_game]);
-	return 0;
+	Telemetry telemetry;
+	if (!telemetry_create(&telemetry, options->telemetry_name))
+		fprintf(stderr, "WARNING: Training without telemetry.\n");
+
+	MetricsWriter *metrics = NULL;
+	if (options->metrics_prefix != NULL) {
+		metrics = metrics_open(options->metrics_prefix, options->metrics_csv);
+		if (metrics == NULL) {
+			telemetry_close(&telemetry);
+			free(game);
+			return 1;
+		}
+	}
+
+	struct timespec *last_epoch = calloc(options->islands_count, sizeof(*last_epoch));
+	SteadyStateRun *run = last_epoch != NULL ? steady_state_start(game, options->islands_count, seed) : NULL;
+	if (run == NULL) {
+		telemetry_close(&telemetry);
+		if (metrics != NULL)
+			metrics_close(metrics);
+		free(last_epoch);
+		free(game);
+		return 1;
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (size_t i = 0; i < run->islands_count; ++i)
+		last_epoch[i] = start;
+
+	TrainingBudget budget;
+	training_budget_start(&budget, &options->stopping);
+
+	for (size_t i = 0; i < epochs; ++i) {
+		SteadyIsland *island = steady_state_wait_epoch(run);
+		size_t island_index = (size_t)(island - run->islands);
+		const SteadyState *state = &island->state;
+
+		GenerationStats stats;
+		Game *epoch = (Game *)state->epoch;
+		double elapsed = seconds_since(&last_epoch[island_index]);
+		clock_gettime(CLOCK_MONOTONIC, &last_epoch[island_index]);
+
+		generation_stats_compute(&stats, &epoch, 1);
+		stats.generation = i + 1;
+		stats.ticks = state->epoch_ticks;
+		stats.ticks_per_second = elapsed > 0 ? (float)((double)stats.ticks / elapsed) : 0.f;
+		telemetry_publish(&telemetry, &stats);
+
+		if (metrics != NULL) {
+			metrics_write_generation(metrics, &stats);
+			metrics_write_agents(metrics, stats.generation, island_index, epoch);
+		}
+
+		fprintf(stdout,
+			"Epoch `%zu`    island: %3zu    tick: %8zu    best lifetime: %3u    mean lifetime: %6.2f    "
+			"hall of fame: %3zu\n",
+			i + 1,
+			island_index,
+			state->tick,
+			stats.best_lifetime,
+			(double)stats.mean_lifetime,
+			fitness_heap_best_lifetime(&state->heap));
+
+		steady_state_release(run, island);
+
+		StopReason reason = training_budget_check(&budget, &stats);
+		if (reason != SR_NONE) {
+			fprintf(stdout,
+				"INFO: Stopping after epoch %zu, %s (best lifetime %u in epoch %llu).\n",
+				i + 1,
+				stop_reason_as_cstr(reason),
+				budget.best_lifetime,
+				(unsigned long long)budget.best_generation);
+			break;
+		}
+	}
+
+	bool complete = true;
+	steady_state_stop(run, game);
+	telemetry_close(&telemetry);
+	if (metrics != NULL)
+		complete = metrics_close(metrics) && complete;
+
+	dump_game_state(filepath, game);
+
+	free(last_epoch);
+	free(game);
+	return complete ? 0 : 1;
 }
@@ -0,0 +1,50 @@
+#include "training_budget.h"
+
+void training_budget_start(TrainingBudget *budget, const StoppingCriteria *criteria) {
+	budget->criteria = *criteria;
+	budget->best_lifetime = 0;
+	budget->best_generation = 0;
+	clock_gettime(CLOCK_MONOTONIC, &budget->start);
+}
+
+StopReason training_budget_check(TrainingBudget *budget, const GenerationStats *stats) {
+	const StoppingCriteria *criteria = &budget->criteria;
+
+	if (stats->best_lifetime > budget->best_lifetime || budget->best_generation == 0) {
+		budget->best_lifetime = stats->best_lifetime;
+		budget->best_generation = stats->generation;
+	}
+
+	if (criteria->target_lifetime > 0 && stats->best_lifetime >= criteria->target_lifetime)
+		return SR_TARGET;
+
+	if (criteria->patience > 0 && stats->generation - budget->best_generation >= criteria->patience)
+		return SR_PLATEAU;
+
+	if (criteria->diversity_floor > 0.f && stats->diversity < criteria->diversity_floor)
+		return SR_DIVERSITY;
+
+	if (criteria->time_budget > 0) {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		double elapsed = (double)(now.tv_sec - budget->start.tv_sec) +
+				 (double)(now.tv_nsec - budget->start.tv_nsec) / 1e9;
+		if (elapsed >= (double)criteria->time_budget)
+			return SR_TIME;
+	}
+
+	return SR_NONE;
+}
+
+const char *stop_reason_as_cstr(StopReason reason) {
+	switch (reason) {
+	case SR_NONE: return "nothing to stop for";
+	case SR_PLATEAU: return "the best lifetime stopped improving";
+	case SR_TARGET: return "the target lifetime is reached";
+	case SR_TIME: return "the time budget is spent";
+	case SR_DIVERSITY: return "the genomes became too much alike";
+	}
+
+	return "unknown reason";
+}
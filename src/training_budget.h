@@ -0,0 +1,39 @@
+#ifndef TRAINING_BUDGET_H
+#define TRAINING_BUDGET_H
+
+#include "stats.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// Every criterion is off when it's zero.
+typedef struct {
+	size_t patience; // generations in a row without a new best lifetime
+	size_t target_lifetime;
+	size_t time_budget; // seconds, checked between generations so the last one may run over it
+	float diversity_floor; // see GenerationStats.diversity
+} StoppingCriteria;
+
+typedef enum {
+	SR_NONE = 0,
+	SR_PLATEAU,
+	SR_TARGET,
+	SR_TIME,
+	SR_DIVERSITY,
+} StopReason;
+
+typedef struct {
+	StoppingCriteria criteria;
+	struct timespec start;
+	uint32_t best_lifetime;
+	uint64_t best_generation;
+} TrainingBudget;
+
+void training_budget_start(TrainingBudget *budget, const StoppingCriteria *criteria);
+
+// Takes the stats of every generation in order, returns why the training should stop after it.
+StopReason training_budget_check(TrainingBudget *budget, const GenerationStats *stats);
+const char *stop_reason_as_cstr(StopReason reason);
+
+#endif // !TRAINING_BUDGET_H
@@ -0,0 +1,354 @@
+#include "verify.h"
+
+#include "worker_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ull
+#define FNV_PRIME 0x100000001B3ull
+
+uint64_t hash_value(uint64_t hash, int64_t value);
+uint64_t hash_agent(uint64_t hash, const Agent *agent, const Chromosome *genome);
+bool report_value(FILE *stream, const char *entity, size_t index, const char *field, long long expected, long long actual);
+size_t report_agent_divergence(FILE *stream,
+			       size_t index,
+			       const Agent *expected,
+			       const Chromosome *expected_genome,
+			       const Agent *actual,
+			       const Chromosome *actual_genome);
+bool verify_step(const Game *reference, const Game *optimized, const char *when, size_t generation, size_t tick);
+bool verify_bred(const Game *reference, const Game *optimized, const char *how, size_t generation, size_t game);
+
+// FNV-1a over the bytes of the value.
+uint64_t hash_value(uint64_t hash, int64_t value) {
+	uint64_t bits = (uint64_t)value;
+
+	for (size_t i = 0; i < sizeof(bits); ++i) {
+		hash ^= (bits >> (8 * i)) & 0xFF;
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+uint64_t hash_agent(uint64_t hash, const Agent *agent, const Chromosome *genome) {
+	hash = hash_value(hash, (int64_t)agent->index);
+	hash = hash_value(hash, agent->pos.x);
+	hash = hash_value(hash, agent->pos.y);
+	hash = hash_value(hash, agent->direction);
+	hash = hash_value(hash, agent->current_state);
+	hash = hash_value(hash, agent->hunger);
+	hash = hash_value(hash, agent->health);
+	hash = hash_value(hash, (int64_t)agent->lifetime);
+	hash = hash_value(hash, agent->death_cause);
+	hash = hash_value(hash, (int64_t)agent->food_eaten);
+	hash = hash_value(hash, (int64_t)agent->attacks_dealt);
+	hash = hash_value(hash, (int64_t)agent->attacks_received);
+
+	for (size_t i = 0; i < GENES_COUNT; ++i) {
+		const Gene *gene = &genome->genes[i];
+		hash = hash_value(hash, agent->gene_usage[i]);
+		hash = hash_value(hash, gene->current_state);
+		hash = hash_value(hash, gene->environment);
+		hash = hash_value(hash, gene->action);
+		hash = hash_value(hash, gene->next_state);
+	}
+
+#if GAME_RECORD_HISTORY
+	size_t recorded = agent->lifetime < MAX_LIFETIME ? agent->lifetime + 1 : MAX_LIFETIME;
+	for (size_t i = 0; i < recorded; ++i) {
+		hash = hash_value(hash, agent->action_history[i]);
+		hash = hash_value(hash, agent->used_genes_history[i]);
+	}
+#endif
+
+	return hash;
+}
+
+uint64_t game_hash(const Game *game) {
+	uint64_t hash = FNV_OFFSET_BASIS;
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i)
+		hash = hash_agent(hash, &game->agents[i], &game->genomes[i]);
+
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		hash = hash_value(hash, game->food[i].pos.x);
+		hash = hash_value(hash, game->food[i].pos.y);
+		hash = hash_value(hash, game->food[i].quantity);
+	}
+
+	for (size_t i = 0; i < WALLS_COUNT; ++i) {
+		hash = hash_value(hash, game->walls[i].pos.x);
+		hash = hash_value(hash, game->walls[i].pos.y);
+	}
+
+	return hash;
+}
+
+bool report_value(FILE *stream, const char *entity, size_t index, const char *field, long long expected, long long actual) {
+	if (expected == actual)
+		return false;
+
+	fprintf(stream, "\t%s %3zu  %-24s reference: %6lld    optimized: %6lld\n", entity, index, field, expected, actual);
+	return true;
+}
+
+size_t report_agent_divergence(FILE *stream,
+			       size_t index,
+			       const Agent *expected,
+			       const Chromosome *expected_genome,
+			       const Agent *actual,
+			       const Chromosome *actual_genome) {
+	size_t count = 0;
+
+	count += report_value(stream, "agent", index, "index", (long long)expected->index, (long long)actual->index);
+	count += report_value(stream, "agent", index, "pos.x", expected->pos.x, actual->pos.x);
+	count += report_value(stream, "agent", index, "pos.y", expected->pos.y, actual->pos.y);
+	count += report_value(stream, "agent", index, "direction", expected->direction, actual->direction);
+	count += report_value(stream, "agent", index, "current_state", expected->current_state, actual->current_state);
+	count += report_value(stream, "agent", index, "hunger", expected->hunger, actual->hunger);
+	count += report_value(stream, "agent", index, "health", expected->health, actual->health);
+	count += report_value(stream, "agent", index, "lifetime", (long long)expected->lifetime, (long long)actual->lifetime);
+	count += report_value(stream, "agent", index, "death_cause", expected->death_cause, actual->death_cause);
+	count += report_value(stream, "agent", index, "food_eaten", (long long)expected->food_eaten, (long long)actual->food_eaten);
+	count += report_value(stream,
+			      "agent",
+			      index,
+			      "attacks_dealt",
+			      (long long)expected->attacks_dealt,
+			      (long long)actual->attacks_dealt);
+	count += report_value(stream,
+			      "agent",
+			      index,
+			      "attacks_received",
+			      (long long)expected->attacks_received,
+			      (long long)actual->attacks_received);
+
+	char field[64];
+	for (size_t i = 0; i < GENES_COUNT; ++i) {
+		snprintf(field, sizeof(field), "gene_usage[%zu]", i);
+		count += report_value(stream, "agent", index, field, expected->gene_usage[i], actual->gene_usage[i]);
+
+		if (memcmp(&expected_genome->genes[i], &actual_genome->genes[i], sizeof(Gene)) != 0) {
+			fprintf(stream, "\tagent %3zu  genes[%zu] differs:\n", index, i);
+			print_gene(stream, &expected_genome->genes[i], index, i);
+			print_gene(stream, &actual_genome->genes[i], index, i);
+			count += 1;
+		}
+	}
+
+#if GAME_RECORD_HISTORY
+	size_t recorded = expected->lifetime < MAX_LIFETIME ? expected->lifetime + 1 : MAX_LIFETIME;
+	for (size_t i = 0; i < recorded; ++i) {
+		snprintf(field, sizeof(field), "action_history[%zu]", i);
+		count += report_value(stream, "agent", index, field, expected->action_history[i], actual->action_history[i]);
+		snprintf(field, sizeof(field), "used_genes_history[%zu]", i);
+		count += report_value(
+			stream, "agent", index, field, expected->used_genes_history[i], actual->used_genes_history[i]);
+	}
+#endif
+
+	return count;
+}
+
+size_t report_divergence(FILE *stream, const Game *expected, const Game *actual) {
+	size_t count = 0;
+
+	for (size_t i = 0; i < AGENTS_COUNT; ++i)
+		count += report_agent_divergence(
+			stream, i, &expected->agents[i], &expected->genomes[i], &actual->agents[i], &actual->genomes[i]);
+
+	for (size_t i = 0; i < FOOD_COUNT; ++i) {
+		count += report_value(stream, "food ", i, "pos.x", expected->food[i].pos.x, actual->food[i].pos.x);
+		count += report_value(stream, "food ", i, "pos.y", expected->food[i].pos.y, actual->food[i].pos.y);
+		count += report_value(stream, "food ", i, "quantity", expected->food[i].quantity, actual->food[i].quantity);
+	}
+
+	for (size_t i = 0; i < WALLS_COUNT; ++i) {
+		count += report_value(stream, "wall ", i, "pos.x", expected->walls[i].pos.x, actual->walls[i].pos.x);
+		count += report_value(stream, "wall ", i, "pos.y", expected->walls[i].pos.y, actual->walls[i].pos.y);
+	}
+
+	return count;
+}
+
+bool verify_step(const Game *reference, const Game *optimized, const char *when, size_t generation, size_t tick) {
+	if (game_hash(reference) == game_hash(optimized))
+		return true;
+
+	fprintf(stderr, "ERROR: The engines diverged in generation %zu %s %zu:\n", generation, when, tick);
+	size_t count = report_divergence(stderr, reference, optimized);
+	if (count == 0)
+		fprintf(stderr, "\tthe hashes differ, but every field is the same (is game_hash in sync with Game?)\n");
+
+	return false;
+}
+
+bool verify_bred(const Game *reference, const Game *optimized, const char *how, size_t generation, size_t game) {
+	if (game_hash(reference) == game_hash(optimized))
+		return true;
+
+	fprintf(stderr, "ERROR: Game %zu of generation %zu was bred differently %s:\n", game, generation, how);
+	size_t count = report_divergence(stderr, reference, optimized);
+	if (count == 0)
+		fprintf(stderr, "\tthe hashes differ, but every field is the same (is game_hash in sync with Game?)\n");
+
+	return false;
+}
+
+bool verify_engines(unsigned int seed, size_t generations) {
+	// Optimized current/next, reference current/next, optimized with a decision table.
+	Game *games = malloc(5 * sizeof(Game));
+	if (games == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate the games to verify.\n");
+		return false;
+	}
+
+	Game *optimized = &games[0];
+	Game *optimized_next = &games[1];
+	Game *reference = &games[2];
+	Game *reference_next = &games[3];
+	Game *tabled = &games[4];
+
+	seed_random(seed);
+	initialize_game(optimized);
+	memcpy(reference, optimized, sizeof(*reference));
+
+	bool result = true;
+	for (size_t generation = 1; generation <= generations && result; ++generation) {
+		size_t tick = 0;
+
+		// Both ways of picking genes are checked, the table is what whole games are played with.
+		DecisionTable table;
+		memcpy(tabled, optimized, sizeof(*tabled));
+		const DecisionTable *decisions = decision_table_build(&table, tabled);
+
+		while (result && !(is_everyone_dead(reference) && is_everyone_dead(optimized) && is_everyone_dead(tabled))) {
+			tick += 1;
+			game_step_reference(reference);
+			game_step(optimized);
+			game_step_with_table(tabled, decisions);
+			result = verify_step(reference, optimized, "after tick", generation, tick) &&
+				 verify_step(reference, tabled, "with a decision table after tick", generation, tick);
+		}
+
+		if (!result)
+			break;
+
+		// Breeding draws random numbers, both engines have to get the same ones.
+		// Only the next games are compared, the reference sorts the agents of the finished one in place.
+		seed_random(seed + (unsigned int)generation);
+		prepare_next_game_reference(reference, reference_next);
+		seed_random(seed + (unsigned int)generation);
+		prepare_next_game(optimized, optimized_next);
+
+		result = verify_step(reference_next, optimized_next, "while breeding after tick", generation, tick);
+		if (!result)
+			break;
+
+		fprintf(stdout,
+			"INFO: Generation %zu matches after %zu ticks, state hash %016llx.\n",
+			generation,
+			tick,
+			(unsigned long long)game_hash(optimized));
+
+		Game *swap = optimized;
+		optimized = optimized_next;
+		optimized_next = swap;
+		swap = reference;
+		reference = reference_next;
+		reference_next = swap;
+	}
+
+	if (result)
+		fprintf(stdout, "INFO: Both engines agree on %zu generations from seed %u.\n", generations, seed);
+
+	free(games);
+	return result;
+}
+
+bool verify_pool(unsigned int seed, size_t generations) {
+	// Local current/next and pooled current/next of every game, then the reference's copy and next game.
+	Game *games = calloc(4 * VERIFY_POOL_GAMES + 2, sizeof(Game));
+	if (games == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate the games to verify.\n");
+		return false;
+	}
+
+	Game *local = &games[0];
+	Game *local_next = &games[VERIFY_POOL_GAMES];
+	Game *pooled = &games[2 * VERIFY_POOL_GAMES];
+	Game *pooled_next = &games[3 * VERIFY_POOL_GAMES];
+	Game *reference = &games[4 * VERIFY_POOL_GAMES];
+	Game *reference_next = &games[4 * VERIFY_POOL_GAMES + 1];
+
+	WorkerPool pool;
+	if (!worker_pool_start(&pool, VERIFY_POOL_WORKERS, MATING_SELECTION_POOL)) {
+		free(games);
+		return false;
+	}
+
+	seed_random(seed);
+	for (size_t i = 0; i < VERIFY_POOL_GAMES; ++i) {
+		initialize_game(&local[i]);
+		memcpy(&pooled[i], &local[i], sizeof(pooled[i]));
+	}
+
+	bool result = true;
+	for (size_t generation = 1; generation <= generations && result; ++generation) {
+		Game *evaluated[VERIFY_POOL_GAMES];
+		for (size_t i = 0; i < VERIFY_POOL_GAMES; ++i) {
+			play_game(&local[i], MATING_SELECTION_POOL);
+			evaluated[i] = &pooled[i];
+		}
+
+		if (!worker_pool_evaluate(&pool, evaluated, VERIFY_POOL_GAMES)) {
+			fprintf(stderr, "ERROR: The pool couldn't evaluate generation %zu.\n", generation);
+			result = false;
+			break;
+		}
+
+		// Every game breeds from the same random numbers all three ways, the reference sorts its copy in place.
+		for (size_t i = 0; i < VERIFY_POOL_GAMES && result; ++i) {
+			unsigned int breeding_seed = seed + (unsigned int)(generation * VERIFY_POOL_GAMES + i);
+			memcpy(reference, &local[i], sizeof(*reference));
+			seed_random(breeding_seed);
+			prepare_next_game_reference(reference, reference_next);
+			seed_random(breeding_seed);
+			prepare_next_game(&local[i], &local_next[i]);
+			seed_random(breeding_seed);
+			prepare_next_game(&pooled[i], &pooled_next[i]);
+
+			result = verify_bred(reference_next, &local_next[i], "in this process", generation, i) &&
+				 verify_bred(reference_next, &pooled_next[i], "after the pool", generation, i);
+		}
+
+		if (!result)
+			break;
+
+		fprintf(stdout,
+			"INFO: Generation %zu of %d games stopped at %d survivors breeds the same through the pool.\n",
+			generation,
+			VERIFY_POOL_GAMES,
+			MATING_SELECTION_POOL);
+
+		Game *swap = local;
+		local = local_next;
+		local_next = swap;
+		swap = pooled;
+		pooled = pooled_next;
+		pooled_next = swap;
+	}
+
+	if (result)
+		fprintf(stdout,
+			"INFO: %d workers and this process agree on %zu generations from seed %u.\n",
+			VERIFY_POOL_WORKERS,
+			generations,
+			seed);
+
+	worker_pool_stop(&pool);
+	free(games);
+	return result;
+}
@@ -0,0 +1,31 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include "game.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define VERIFY_DEFAULT_GENERATIONS 16
+#define VERIFY_POOL_WORKERS 2
+#define VERIFY_POOL_GAMES 4
+
+// Hash of everything the rules can change, padding and unused history entries don't count.
+uint64_t game_hash(const Game *game);
+
+// Prints every field where `expected` and `actual` disagree, returns the number of those fields.
+size_t report_divergence(FILE *stream, const Game *expected, const Game *actual);
+
+// Plays `generations` generations from `seed` with the reference and the optimized engine side by side
+// (the latter both scanning genes and with a decision table), stops at the first tick or breeding step
+// after which they aren't in the same state.
+bool verify_engines(unsigned int seed, size_t generations);
+
+// Plays `generations` generations of a few games stopped at MATING_SELECTION_POOL survivors, the way
+// --adaptive-ticks does, in this process and through a pool of workers, and checks that both breed
+// the same next games as the reference engine does.
+bool verify_pool(unsigned int seed, size_t generations);
+
+#endif // !VERIFY_H
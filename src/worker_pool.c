@@ -0,0 +1,433 @@
+#include "worker_pool.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WORKER_MESSAGE_MAGIC 0x4C505047u // "GPPL"
+#define NO_DEADLINE -1
+
+typedef enum {
+	BATCH_PENDING = 0,
+	BATCH_RUNNING,
+	BATCH_DONE,
+} PoolBatchState;
+
+typedef struct {
+	size_t first;
+	size_t count;
+	size_t attempts;
+	PoolBatchState state;
+} PoolBatch;
+
+bool worker_pool_spawn(WorkerPool *pool, PoolWorker *worker);
+void worker_pool_kill(PoolWorker *worker);
+void worker_pool_restart(WorkerPool *pool, PoolWorker *worker, PoolBatch *batches, Game *games[]);
+void worker_pool_serve(int fd, size_t survivors);
+
+bool worker_pool_send_batch(PoolWorker *worker, size_t batch_index, const PoolBatch *batch, Game *games[]);
+bool worker_pool_receive_fitness(PoolWorker *worker, const PoolBatch *batch, Game *games[]);
+void worker_pool_evaluate_locally(const WorkerPool *pool, Game *games[], size_t first, size_t count);
+
+int64_t monotonic_ms(void);
+bool wait_for_fd(int fd, short events, int64_t deadline_ms);
+bool send_all(int fd, const void *data, size_t size, int64_t deadline_ms);
+bool receive_all(int fd, void *data, size_t size, int64_t deadline_ms);
+
+bool worker_pool_start(WorkerPool *pool, size_t workers_count, size_t survivors) {
+	memset(pool, 0, sizeof(*pool));
+	pool->survivors = survivors;
+
+	if (workers_count > WORKER_POOL_MAX_WORKERS)
+		workers_count = WORKER_POOL_MAX_WORKERS;
+
+	for (size_t i = 0; i < workers_count; ++i) {
+		pool->workers[i].fd = -1;
+		pool->workers_count += 1;
+
+		if (!worker_pool_spawn(pool, &pool->workers[i])) {
+			worker_pool_stop(pool);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void worker_pool_stop(WorkerPool *pool) {
+	// Workers exit as soon as they see the end of the stream.
+	for (size_t i = 0; i < pool->workers_count; ++i) {
+		if (pool->workers[i].fd >= 0)
+			close(pool->workers[i].fd);
+		pool->workers[i].fd = -1;
+	}
+
+	for (size_t i = 0; i < pool->workers_count; ++i) {
+		if (pool->workers[i].pid > 0)
+			waitpid(pool->workers[i].pid, NULL, 0);
+		pool->workers[i].pid = 0;
+	}
+
+	pool->workers_count = 0;
+}
+
+bool worker_pool_spawn(WorkerPool *pool, PoolWorker *worker) {
+	int fds[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+		fprintf(stderr, "ERROR: Couldn't create a socket for the worker: %s.\n", strerror(errno));
+		return false;
+	}
+
+	// Otherwise whatever the master has buffered gets printed once more by every child.
+	fflush(stdout);
+	fflush(stderr);
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		fprintf(stderr, "ERROR: Couldn't fork the worker: %s.\n", strerror(errno));
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if (pid == 0) {
+		close(fds[0]);
+		for (size_t i = 0; i < pool->workers_count; ++i) {
+			if (pool->workers[i].fd >= 0)
+				close(pool->workers[i].fd);
+		}
+
+		worker_pool_serve(fds[1], pool->survivors);
+		_exit(0);
+	}
+
+	close(fds[1]);
+	worker->pid = pid;
+	worker->fd = fds[0];
+	worker->busy = false;
+	return true;
+}
+
+void worker_pool_kill(PoolWorker *worker) {
+	if (worker->fd >= 0)
+		close(worker->fd);
+	if (worker->pid > 0) {
+		kill(worker->pid, SIGKILL);
+		waitpid(worker->pid, NULL, 0);
+	}
+
+	worker->fd = -1;
+	worker->pid = 0;
+	worker->busy = false;
+}
+
+// The batch of a lost worker goes back to the queue, unless it has already taken down too many of them.
+void worker_pool_restart(WorkerPool *pool, PoolWorker *worker, PoolBatch *batches, Game *games[]) {
+	if (worker->busy) {
+		PoolBatch *batch = &batches[worker->batch];
+		batch->attempts += 1;
+
+		if (batch->attempts >= WORKER_POOL_MAX_ATTEMPTS) {
+			fprintf(stderr, "WARNING: Batch %zu lost %zu workers, evaluating it here.\n", worker->batch, batch->attempts);
+			worker_pool_evaluate_locally(pool, games, batch->first, batch->count);
+			batch->state = BATCH_DONE;
+		} else {
+			batch->state = BATCH_PENDING;
+		}
+	}
+
+	worker_pool_kill(worker);
+	worker->restarts += 1;
+
+	if (worker_pool_spawn(pool, worker))
+		fprintf(stderr, "WARNING: Worker was restarted (%zu restarts so far).\n", worker->restarts);
+}
+
+bool worker_pool_evaluate(WorkerPool *pool, Game *games[], size_t games_count) {
+	if (pool->workers_count == 0) {
+		worker_pool_evaluate_locally(pool, games, 0, games_count);
+		return true;
+	}
+
+	// One batch per worker keeps the messages as big as possible.
+	size_t batch_size = (games_count + pool->workers_count - 1) / pool->workers_count;
+	size_t batches_count = batch_size > 0 ? (games_count + batch_size - 1) / batch_size : 0;
+	PoolBatch *batches = calloc(batches_count > 0 ? batches_count : 1, sizeof(*batches));
+
+	if (batches == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate the evaluation batches.\n");
+		return false;
+	}
+
+	for (size_t i = 0; i < batches_count; ++i) {
+		batches[i].first = i * batch_size;
+		batches[i].count = games_count - batches[i].first < batch_size ? games_count - batches[i].first : batch_size;
+	}
+
+	struct pollfd fds[WORKER_POOL_MAX_WORKERS];
+	size_t polled_workers[WORKER_POOL_MAX_WORKERS];
+
+	for (;;) {
+		size_t remaining = 0;
+		size_t next_pending = 0;
+
+		for (size_t i = 0; i < batches_count; ++i)
+			remaining += batches[i].state != BATCH_DONE;
+		if (remaining == 0)
+			break;
+
+		for (size_t i = 0; i < pool->workers_count; ++i) {
+			PoolWorker *worker = &pool->workers[i];
+			if (worker->busy || worker->fd < 0)
+				continue;
+
+			while (next_pending < batches_count && batches[next_pending].state != BATCH_PENDING)
+				next_pending += 1;
+			if (next_pending == batches_count)
+				break;
+
+			worker->batch = next_pending;
+			worker->busy = true;
+			batches[next_pending].state = BATCH_RUNNING;
+
+			if (!worker_pool_send_batch(worker, next_pending, &batches[next_pending], games))
+				worker_pool_restart(pool, worker, batches, games);
+		}
+
+		nfds_t polled_count = 0;
+		for (size_t i = 0; i < pool->workers_count; ++i) {
+			if (!pool->workers[i].busy)
+				continue;
+
+			fds[polled_count] = (struct pollfd){ .fd = pool->workers[i].fd, .events = POLLIN };
+			polled_workers[polled_count] = i;
+			polled_count += 1;
+		}
+
+		// Every worker is gone and can't be forked again, the master has to do the rest.
+		if (polled_count == 0) {
+			for (size_t i = 0; i < batches_count; ++i) {
+				if (batches[i].state != BATCH_PENDING)
+					continue;
+				worker_pool_evaluate_locally(pool, games, batches[i].first, batches[i].count);
+				batches[i].state = BATCH_DONE;
+			}
+			continue;
+		}
+
+		// Wake up for the earliest deadline even if nobody answers.
+		int64_t now = monotonic_ms();
+		int64_t earliest = pool->workers[polled_workers[0]].deadline_ms;
+		for (nfds_t i = 1; i < polled_count; ++i) {
+			if (pool->workers[polled_workers[i]].deadline_ms < earliest)
+				earliest = pool->workers[polled_workers[i]].deadline_ms;
+		}
+		int timeout = earliest > now ? (int)(earliest - now) : 0;
+
+		if (poll(fds, polled_count, timeout) < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "ERROR: Couldn't wait for the workers: %s.\n", strerror(errno));
+			free(batches);
+			return false;
+		}
+
+		now = monotonic_ms();
+		for (nfds_t i = 0; i < polled_count; ++i) {
+			PoolWorker *worker = &pool->workers[polled_workers[i]];
+			PoolBatch *batch = &batches[worker->batch];
+
+			if (fds[i].revents == 0) {
+				if (now < worker->deadline_ms)
+					continue;
+
+				// Alive but stopped or stuck, it's handled just like a dead one.
+				fprintf(stderr,
+					"WARNING: Worker %d didn't evaluate batch %zu in time.\n",
+					(int)worker->pid,
+					worker->batch);
+				worker_pool_restart(pool, worker, batches, games);
+				continue;
+			}
+
+			if (worker_pool_receive_fitness(worker, batch, games)) {
+				batch->state = BATCH_DONE;
+				worker->busy = false;
+			} else {
+				worker_pool_restart(pool, worker, batches, games);
+			}
+		}
+	}
+
+	free(batches);
+	return true;
+}
+
+bool worker_pool_send_batch(PoolWorker *worker, size_t batch_index, const PoolBatch *batch, Game *games[]) {
+	PackedGame *packed = malloc(batch->count * sizeof(*packed));
+	if (packed == NULL)
+		return false;
+
+	for (size_t i = 0; i < batch->count; ++i)
+		pack_game(games[batch->first + i], &packed[i]);
+
+	// Sending counts against the deadline too, a worker that doesn't read fills up the socket.
+	worker->deadline_ms = monotonic_ms() + WORKER_POOL_TIMEOUT_MS + (int64_t)batch->count * WORKER_POOL_TIMEOUT_PER_GAME_MS;
+
+	WorkerMessageHeader header = {
+		WORKER_MESSAGE_MAGIC,
+		WM_EVALUATE,
+		(uint32_t)batch_index,
+		(uint32_t)batch->count,
+	};
+	bool result = send_all(worker->fd, &header, sizeof(header), worker->deadline_ms) &&
+		      send_all(worker->fd, packed, batch->count * sizeof(*packed), worker->deadline_ms);
+
+	free(packed);
+	return result;
+}
+
+bool worker_pool_receive_fitness(PoolWorker *worker, const PoolBatch *batch, Game *games[]) {
+	WorkerMessageHeader header;
+	if (!receive_all(worker->fd, &header, sizeof(header), worker->deadline_ms))
+		return false;
+
+	if (header.magic != WORKER_MESSAGE_MAGIC || header.type != WM_FITNESS ||
+	    header.batch_id != (uint32_t)worker->batch || header.games_count != (uint32_t)batch->count) {
+		fprintf(stderr, "ERROR: Worker %d sent an unexpected message.\n", (int)worker->pid);
+		return false;
+	}
+
+	PackedFitness *fitness = malloc(batch->count * sizeof(*fitness));
+	if (fitness == NULL || !receive_all(worker->fd, fitness, batch->count * sizeof(*fitness), worker->deadline_ms)) {
+		free(fitness);
+		return false;
+	}
+
+	for (size_t i = 0; i < batch->count; ++i)
+		apply_fitness(&fitness[i], games[batch->first + i]);
+
+	free(fitness);
+	return true;
+}
+
+void worker_pool_evaluate_locally(const WorkerPool *pool, Game *games[], size_t first, size_t count) {
+	for (size_t i = first; i < first + count; ++i)
+		play_game(games[i], pool->survivors);
+}
+
+// Body of a worker process: answers evaluation requests until the master hangs up.
+void worker_pool_serve(int fd, size_t survivors) {
+	Game *game = malloc(sizeof(*game));
+	if (game == NULL)
+		return;
+
+	WorkerMessageHeader header;
+	while (receive_all(fd, &header, sizeof(header), NO_DEADLINE)) {
+		if (header.magic != WORKER_MESSAGE_MAGIC || header.type != WM_EVALUATE || header.games_count == 0)
+			break;
+
+		PackedGame *packed = malloc(header.games_count * sizeof(*packed));
+		PackedFitness *fitness = malloc(header.games_count * sizeof(*fitness));
+		if (packed == NULL || fitness == NULL || !receive_all(fd, packed, header.games_count * sizeof(*packed), NO_DEADLINE)) {
+			free(packed);
+			free(fitness);
+			break;
+		}
+
+		for (size_t i = 0; i < header.games_count; ++i) {
+			unpack_game(&packed[i], game);
+			play_game(game, survivors);
+			pack_fitness(game, &fitness[i]);
+		}
+
+		header.type = WM_FITNESS;
+		bool sent = send_all(fd, &header, sizeof(header), NO_DEADLINE) &&
+			    send_all(fd, fitness, header.games_count * sizeof(*fitness), NO_DEADLINE);
+
+		free(packed);
+		free(fitness);
+		if (!sent)
+			break;
+	}
+
+	fflush(stdout);
+	free(game);
+	close(fd);
+}
+
+int64_t monotonic_ms(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Returns false once the deadline passes, NO_DEADLINE waits for as long as it takes.
+bool wait_for_fd(int fd, short events, int64_t deadline_ms) {
+	if (deadline_ms == NO_DEADLINE)
+		return true;
+
+	for (;;) {
+		int64_t now = monotonic_ms();
+		if (now >= deadline_ms)
+			return false;
+
+		struct pollfd polled = { .fd = fd, .events = events };
+		int ready = poll(&polled, 1, (int)(deadline_ms - now));
+		if (ready < 0 && errno == EINTR)
+			continue;
+
+		// Errors and hang-ups are for send and recv to report.
+		return ready != 0;
+	}
+}
+
+// MSG_NOSIGNAL: a dead peer is reported as an error instead of killing the process with SIGPIPE.
+// With a deadline, nothing blocks past it: the socket is polled first and never waited on.
+bool send_all(int fd, const void *data, size_t size, int64_t deadline_ms) {
+	const uint8_t *at = data;
+
+	while (size > 0) {
+		if (!wait_for_fd(fd, POLLOUT, deadline_ms))
+			return false;
+
+		ssize_t sent = send(fd, at, size, MSG_NOSIGNAL | (deadline_ms == NO_DEADLINE ? 0 : MSG_DONTWAIT));
+		if (sent < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+			continue;
+		if (sent <= 0)
+			return false;
+
+		at += sent;
+		size -= (size_t)sent;
+	}
+
+	return true;
+}
+
+bool receive_all(int fd, void *data, size_t size, int64_t deadline_ms) {
+	uint8_t *at = data;
+
+	while (size > 0) {
+		if (!wait_for_fd(fd, POLLIN, deadline_ms))
+			return false;
+
+		ssize_t received = recv(fd, at, size, deadline_ms == NO_DEADLINE ? 0 : MSG_DONTWAIT);
+		if (received < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+			continue;
+		if (received <= 0)
+			return false;
+
+		at += received;
+		size -= (size_t)received;
+	}
+
+	return true;
+}
@@ -0,0 +1,68 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include "game.h"
+#include "packed_game.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define WORKER_POOL_MAX_WORKERS 64
+#define WORKER_POOL_MAX_ATTEMPTS 3 // after that many crashed workers the batch is evaluated by the master itself
+// A game runs for at most MAX_LIFETIME ticks, a fraction of a millisecond each: a worker that takes this long
+// is stopped or stuck, not busy.
+#define WORKER_POOL_TIMEOUT_MS 2000
+#define WORKER_POOL_TIMEOUT_PER_GAME_MS 100
+
+/*
+ * Master/worker evaluation over Unix stream sockets.
+ *
+ * The master keeps the populations and does selection, workers are forked processes that only
+ * run games to extinction. A message is a WorkerMessageHeader followed by `games_count` packed
+ * games (master -> worker) or as many PackedFitness records (worker -> master). A whole batch of
+ * populations goes in a single message, so there are two messages per ~games_count * 100k ticks.
+ *
+ * A worker that dies, hangs up, sends garbage or doesn't answer before the deadline of its batch
+ * is killed and forked again, and its batch goes back to the queue. The master never blocks on a
+ * worker past that deadline, not even in the middle of a message. Everything is fixed-width, but in the host byte order: across machines
+ * the same stream would need a byte order in the header.
+ */
+
+typedef enum {
+	WM_EVALUATE = 1,
+	WM_FITNESS,
+} WorkerMessageType;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t type;
+	uint32_t batch_id;
+	uint32_t games_count;
+} WorkerMessageHeader;
+
+typedef struct {
+	pid_t pid;
+	int fd;
+	bool busy;
+	size_t batch; // index of the batch the worker is evaluating
+	int64_t deadline_ms; // CLOCK_MONOTONIC time by which the whole answer has to be in
+	size_t restarts;
+} PoolWorker;
+
+typedef struct {
+	size_t workers_count;
+	size_t survivors; // games stop once no more agents than this are alive, see play_game
+	PoolWorker workers[WORKER_POOL_MAX_WORKERS];
+} WorkerPool;
+
+// With zero workers everything is evaluated in the calling process.
+bool worker_pool_start(WorkerPool *pool, size_t workers_count, size_t survivors);
+void worker_pool_stop(WorkerPool *pool);
+
+// Runs every game to extinction, or down to `survivors`. With workers, games only get what selection needs:
+// lifetimes, health, counters and death causes (see PackedFitness), not the history or the final board.
+bool worker_pool_evaluate(WorkerPool *pool, Game *games[], size_t games_count);
+
+#endif // !WORKER_POOL_H